@@ -0,0 +1,38 @@
+#include "alloccount.hpp"
+#include <atomic>
+#include <cstddef>
+
+static std::atomic<long> heapAllocs{ 0 };
+
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+
+extern "C" void* malloc(size_t n) noexcept {
+    heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(n);
+}
+
+extern "C" void* calloc(size_t n, size_t m) noexcept {
+    heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, m);
+}
+
+extern "C" void* realloc(void* p, size_t n) noexcept {
+    heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, n);
+}
+
+bool countingHeapAllocations() {
+    return true;
+}
+#else
+bool countingHeapAllocations() {
+    return false;
+}
+#endif
+
+long heapAllocations() {
+    return heapAllocs.load(std::memory_order_relaxed);
+}
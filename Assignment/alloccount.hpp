@@ -0,0 +1,9 @@
+#pragma once
+
+// Process-wide heap allocation counter. Linking alloccount.cpp into an executable interposes malloc,
+// calloc and realloc (glibc only), which operator new and GMP both go through; never link it into
+// the library itself.
+
+// Allocations so far; 0 forever when counting isn't available
+long heapAllocations();
+bool countingHeapAllocations();
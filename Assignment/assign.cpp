@@ -1,8 +1,18 @@
 #include "assign.hpp"
+#include "fp256.hpp"
+#include "parallel.hpp"
+#include "simdxor.hpp"
+#include "drbg.hpp"
+#include "sha256.hpp"
+#include "instrument.hpp"
 #include <cstdlib>
-#include <ctime>
 #include <bitset>
+#include <algorithm>
 #include <cctype>
+#include <functional>
+#include <future>
+#include <map>
+#include <tuple>
 #include <stdexcept>
 #include <NTL/ZZ_p.h>
 #include <NTL/ZZ_p.h>
@@ -14,147 +24,113 @@ long mod26(long x) {
 
 
 // Shift Cipher 
-string appliedCryptography::shiftEncrypt(string text, int key) {
-    string result = "";
-    for (char c : text) {
+// Letters go through the SIMD rotation kernel whenever the original formula is a plain rotation
+// (key >= 0 to encrypt, key <= 26 to decrypt); other keys keep the per-character loop.
+string appliedCryptography::shiftEncrypt(const string& text, int key) {
+    string result(text.size(), '\0');
+    if (key >= 0) {
+        rotateLetters((unsigned char*)&result[0], (const unsigned char*)text.data(), text.size(), key % 26);
+        return result;
+    }
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
         if (isalpha(c)) {
             char base = isupper(c) ? 'A' : 'a';
-            result += char((c - base + key) % 26 + base);
+            result[i] = char((c - base + key) % 26 + base);
         } else {
-            result += c;
+            result[i] = c;
         }
     }
     return result;
 }
 
-string appliedCryptography::shiftDecrypt(string text, int key) {
-    string result = "";
-    for (char c : text) {
+string appliedCryptography::shiftDecrypt(const string& text, int key) {
+    string result(text.size(), '\0');
+    if (key <= 26) {
+        rotateLetters((unsigned char*)&result[0], (const unsigned char*)text.data(), text.size(), (26 - key) % 26);
+        return result;
+    }
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
         if (isalpha(c)) {
             char base = isupper(c) ? 'A' : 'a';
-            result += char((c - base - key + 26) % 26 + base);
+            result[i] = char((c - base - key + 26) % 26 + base);
         } else {
-            result += c;
+            result[i] = c;
         }
     }
     return result;
 }
 
 // Vigenere Cipher 
-string appliedCryptography::vigenereEncrypt(string text, string key) {
-    string result = "";
-    int j = 0;
-    for (char c : text) {
+string appliedCryptography::vigenereEncrypt(const string& text, const string& key) {
+    return vigenereEncrypt(text, VigenereKey(key));
+}
+
+string appliedCryptography::vigenereDecrypt(const string& text, const string& key) {
+    return vigenereDecrypt(text, VigenereKey(key));
+}
+
+string appliedCryptography::vigenereEncrypt(const string& text, const VigenereKey& key) {
+    string result(text.size(), '\0');
+    if (key.encRotation) {
+        rotateLettersKeyed((unsigned char*)&result[0], (const unsigned char*)text.data(), text.size(),
+                           key.encStream.data(), key.period, 0);
+        return result;
+    }
+    size_t j = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
         if (isalpha(c)) {
             char base = isupper(c) ? 'A' : 'a';
-            int k = tolower(key[j % key.size()]) - 'a';
-            result += char((c - base + k) % 26 + base);
+            int k = key.shifts[j % key.period];
+            result[i] = char((c - base + k) % 26 + base);
             j++;
         } else {
-            result += c;
+            result[i] = c;
         }
     }
     return result;
 }
 
-string appliedCryptography::vigenereDecrypt(string text, string key) {
-    string result = "";
-    int j = 0;
-    for (char c : text) {
+string appliedCryptography::vigenereDecrypt(const string& text, const VigenereKey& key) {
+    string result(text.size(), '\0');
+    if (key.decRotation) {
+        rotateLettersKeyed((unsigned char*)&result[0], (const unsigned char*)text.data(), text.size(),
+                           key.decStream.data(), key.period, 0);
+        return result;
+    }
+    size_t j = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
         if (isalpha(c)) {
             char base = isupper(c) ? 'A' : 'a';
-            int k = tolower(key[j % key.size()]) - 'a';
-            result += char((c - base - k + 26) % 26 + base);
+            int k = key.shifts[j % key.period];
+            result[i] = char((c - base - k + 26) % 26 + base);
             j++;
         } else {
-            result += c;
+            result[i] = c;
         }
     }
     return result;
 }
 
-// Hill Cipher 
+// Hill Cipher: compile the key (validates it, caches the inverse) and run the blocked multiply
 string appliedCryptography::hillEncrypt(string text, mat_ZZ_p key) {
-    long n = key.NumRows();
-    string result = "";
-
-    ZZ_p::init(ZZ(31)); // prime modulus
-
-    // Convert text to uppercase
-    for(auto &c : text) c = toupper(c);
-
-    // Padding
-    while(text.size() % n != 0) text += 'X';
-
-    for(size_t i = 0; i < text.size(); i += n) {
-        vec_ZZ_p P;
-        P.SetLength(n);
-        for(long j = 0; j < n; j++) {
-            P[j] = ZZ_p(text[i+j] - 'A');
-        }
-
-        vec_ZZ_p C = key * P; // automatically mod 31
-        for(long j = 0; j < n; j++) {
-            result += char(conv<long>(rep(C[j])) + 'A');
-        }
-    }
-
-    return result;
+    return HillKey(key).encrypt(text);
 }
 
 // Hill Decrypt
 string appliedCryptography::hillDecrypt(const string& ciphertext, const mat_ZZ_p& key) {
-    long n = key.NumRows();
-    string result = "";
-
-    ZZ_p::init(ZZ(31)); // same prime modulus
-
-    // Determinant and inverse
-    ZZ_p det;
-    determinant(det, key);
-    ZZ_p detInv = inv(det); // inverse modulo 31
-
-    // Compute adjugate
-    mat_ZZ_p adj;
-    adj.SetDims(n,n);
-    for(long i = 0; i < n; i++) {
-        for(long j = 0; j < n; j++) {
-            mat_ZZ_p minor;
-            minor.SetDims(n-1,n-1);
-            long r = 0;
-            for(long ii = 0; ii < n; ii++) {
-                if(ii == i) continue;
-                long c = 0;
-                for(long jj = 0; jj < n; jj++) {
-                    if(jj == j) continue;
-                    minor[r][c] = key[ii][jj];
-                    c++;
-                }
-                r++;
-            }
-            ZZ_p minorDet;
-            determinant(minorDet, minor);
-            if((i+j)%2 != 0) minorDet = -minorDet;
-            adj[j][i] = minorDet; // transpose for adjugate
-        }
-    }
-
-    mat_ZZ_p invKey = detInv * adj;
+    return HillKey(key).decrypt(ciphertext);
+}
 
-    // Decrypt
-    for(size_t k = 0; k < ciphertext.size(); k += n) {
-        vec_ZZ_p C;
-        C.SetLength(n);
-        for(long j = 0; j < n; j++) {
-            C[j] = ZZ_p(ciphertext[k+j] - 'A');
-        }
-        vec_ZZ_p P = invKey * C;
-        for(long j = 0; j < n; j++) {
-            result += char(conv<long>(rep(P[j])) + 'A');
-        }
-    }
+string appliedCryptography::hillEncrypt(const string& text, const HillKey& key) {
+    return key.encrypt(text);
+}
 
-    return result;
+string appliedCryptography::hillDecrypt(const string& ciphertext, const HillKey& key) {
+    return key.decrypt(ciphertext);
 }
 
 
@@ -162,39 +138,45 @@ string appliedCryptography::hillDecrypt(const string& ciphertext, const mat_ZZ_p
 // OTP
 
 string appliedCryptography::generateRandomKey(int length) {
-    srand(time(0));
-    string key = "";
-    for (int i = 0; i < length; i++) {
-        key += char(rand() % 256); 
-    }
+    if (length <= 0) return "";
+    string key(length, '\0');
+    threadDRBG().fill((unsigned char*)&key[0], length);
     return key;
 }
 
+// XOR with the key through the SIMD kernel
+void appliedCryptography::otpXor(unsigned char* out, const unsigned char* in, size_t n, const unsigned char* key, size_t keyLen) {
+    if (keyLen < n) {
+        throw runtime_error("Key must be at least as long as the data");
+    }
+    xorBytes(out, in, key, n);
+}
+
+void appliedCryptography::otpXorInPlace(unsigned char* data, size_t n, const unsigned char* key, size_t keyLen) {
+    otpXor(data, data, n, key, keyLen);
+}
+
 // Encryption (plaintext XOR key)
-string appliedCryptography::otpEncrypt(string plaintext, string key) {
+string appliedCryptography::otpEncrypt(const string& plaintext, const string& key) {
     if (key.size() < plaintext.size()) {
         throw runtime_error("Key must be at least as long as plaintext");
     }
 
-    string ciphertext = "";
-    for (size_t i = 0; i < plaintext.size(); i++) {
-        char c = plaintext[i] ^ key[i];
-        ciphertext += c;
-    }
+    string ciphertext(plaintext.size(), '\0');
+    xorBytes((unsigned char*)&ciphertext[0], (const unsigned char*)plaintext.data(),
+             (const unsigned char*)key.data(), plaintext.size());
     return ciphertext;
 }
 
 // Decryption (ciphertext XOR key)
-string appliedCryptography::otpDecrypt(string ciphertext, string key) {
+string appliedCryptography::otpDecrypt(const string& ciphertext, const string& key) {
     if (key.size() < ciphertext.size()) {
         throw runtime_error("Key must be at least as long as ciphertext");
     }
 
-    string decrypted = "";
-    for (size_t i = 0; i < ciphertext.size(); i++) {
-        char c = ciphertext[i] ^ key[i];
-        decrypted += c;
-    }
+    string decrypted(ciphertext.size(), '\0');
+    xorBytes((unsigned char*)&decrypted[0], (const unsigned char*)ciphertext.data(),
+             (const unsigned char*)key.data(), ciphertext.size());
     return decrypted;
 }
 
@@ -202,33 +184,77 @@ string appliedCryptography::otpDecrypt(string ciphertext, string key) {
 
 // Diffie Helman Key Exchange
 ZZ_p appliedCryptography::diffiePublicKeyNTL(ZZ_p privateKey, ZZ_p g) {
-    ZZ_p result = power(g, conv<long>(rep(privateKey))); 
-    return result;
+    return diffiePublicKeyNTL(rep(privateKey), g);
 }
 
 ZZ_p appliedCryptography::diffieSharedKeyNTL(ZZ_p receivedKey, ZZ_p privateKey) {
-    ZZ_p result = power(receivedKey, conv<long>(rep(privateKey)));
-    return result;
+    return diffieSharedKeyNTL(receivedKey, rep(privateKey));
 }
 
+ZZ_p appliedCryptography::diffiePublicKeyNTL(const ZZ& privateKey, const ZZ_p& g) {
+    CRYPTO_TIMED();
+    return slidingWindowPower(g, privateKey);
+}
 
+ZZ_p appliedCryptography::diffieSharedKeyNTL(const ZZ_p& receivedKey, const ZZ& privateKey) {
+    CRYPTO_TIMED();
+    return slidingWindowPower(receivedKey, privateKey);
+}
+
+// maxBits = 0 sizes the table for exponents up to the modulus
+ModExpTable appliedCryptography::precomputeDiffieBase(const ZZ_p& g, long maxBits, long w) {
+    if (maxBits <= 0) maxBits = NumBits(ZZ_p::modulus());
+    return buildModExpTable(g, maxBits, w);
+}
 
-// random y generate (1 < y < p-2)
+ZZ_p appliedCryptography::diffiePublicKeyNTL(const ZZ& privateKey, const ModExpTable& g) {
+    return fixedBasePower(g, privateKey);
+}
+
+// One exponent for every peer: recode it once, then each worker runs the same window schedule
+vector<ZZ_p> appliedCryptography::diffieSharedKeysParallel(const vector<ZZ_p>& received, const ZZ& privateKey, unsigned threads) {
+    ZZ_pContext ctx;
+    ctx.save();
+    vector<ZZ_p> out(received.size());
+    if (IsZero(privateKey) || privateKey < 0) {
+        for (size_t i = 0; i < received.size(); i++) out[i] = diffieSharedKeyNTL(received[i], privateKey);
+        return out;
+    }
+
+    ExpRecoding r = slidingWindowRecode(privateKey, slidingWindowWidth(NumBits(privateKey)));
+    parallelFor(received.size(), threads, [&](size_t begin, size_t end) {
+        ZZ_pPush push(ctx);
+        for (size_t i = begin; i < end; i++) out[i] = slidingWindowPower(received[i], r);
+    });
+    return out;
+}
+
+
+
+// random y generate (1 <= y <= p-2), full size for any modulus
 ZZ_p appliedCryptography::generateRandomY() {
-    long y = RandomBnd(conv<long>(ZZ_p::modulus()-2)) + 1;
-    return ZZ_p(y);
+    ZZ y = threadDRBG().randomRange(ZZ(1), ZZ_p::modulus() - 2);
+    return conv<ZZ_p>(y);
 }
 
 // Encrypt
 void appliedCryptography::elGamalEncrypt(const ZZ_p& g, const ZZ_p& h, const ZZ_p& m, ZZ_p& c1, ZZ_p& c2) {
+    CRYPTO_TIMED();
     ZZ_p y = generateRandomY();      // random y
+    CRYPTO_COUNT_N(CTR_MODEXP, 2);
     c1 = power(g, rep(y));           // c1 = g^y mod p
     ZZ_p s = power(h, rep(y));       // s = h^y mod p
     c2 = m * s;                      // c2 = m * s mod p
 }
 
+void appliedCryptography::elGamalEncrypt(const ElGamalEncryptor& enc, const ZZ_p& m, ZZ_p& c1, ZZ_p& c2) {
+    enc.encrypt(m, c1, c2);
+}
+
 // Decrypt
 ZZ_p appliedCryptography::elGamalDecrypt(const ZZ_p& x, const ZZ_p& c1, const ZZ_p& c2) {
+    CRYPTO_TIMED();
+    CRYPTO_COUNT(CTR_MODEXP);
     ZZ_p s = power(c1, rep(x));      // s = c1^x mod p
     ZZ_p s_inv = inv(s);              // s^-1 mod p
     ZZ_p m = c2 * s_inv;              // m = c2 * s^-1 mod p
@@ -236,14 +262,45 @@ ZZ_p appliedCryptography::elGamalDecrypt(const ZZ_p& x, const ZZ_p& c1, const ZZ
 }
 
 
+// Streaming inputs below this are hashed inline: a helper thread costs more than it would hide
+static const long long STREAM_OVERLAP_BYTES = 1 << 16;
+
+static bool overlapHashing(const MessageSource& msg) {
+    long long n = msg.size();
+    return n < 0 || n >= STREAM_OVERLAP_BYTES;
+}
+
+// hashToScalar(msg, n), with large inputs hashed on a helper thread while precompute() runs on this
+// one. The helper only builds a ZZ, so it doesn't need the caller's ZZ_p modulus.
+template<class F>
+static ZZ hashAlongside(const MessageSource& msg, const ZZ& n, F precompute) {
+    if (!overlapHashing(msg)) {
+        precompute();
+        return hashToScalar(msg, n);
+    }
+    future<ZZ> digest = async(launch::async, [&msg, &n] { return hashToScalar(msg, n); });
+    precompute();
+    return digest.get();
+}
+
+
+// ElGamal nonce: uniform in [1, p-2] and coprime to p-1; each redraw counts as a retry
+static ZZ randomUnitNonce(const ZZ& p1) {
+    ZZ y = threadDRBG().randomRange(ZZ(1), p1 - 1);
+    while (GCD(y, p1) != 1) {
+        CRYPTO_COUNT(CTR_RNG_RETRY);
+        y = threadDRBG().randomRange(ZZ(1), p1 - 1);
+    }
+    return y;
+}
+
  // ElGamal Digital Signature
 void appliedCryptography::elGamalSign(const ZZ& p, const ZZ& g, const ZZ& x, const ZZ& m, ZZ& gamma, ZZ& delta) {
+    CRYPTO_TIMED();
     ZZ p1 = p-1;
-    ZZ y;
-    do {
-        y = conv<ZZ>(rand() % conv<long>(p1) + 1);
-    } while(GCD(y,p1)!=1);
+    ZZ y = randomUnitNonce(p1);
 
+    CRYPTO_COUNT(CTR_MODEXP);
     PowerMod(gamma, g, y, p);
     ZZ y_inv = InvMod(y, p1);
     delta = ((m - x*gamma)*y_inv) % p1;
@@ -251,30 +308,256 @@ void appliedCryptography::elGamalSign(const ZZ& p, const ZZ& g, const ZZ& x, con
     }
 
 bool appliedCryptography::elGamalVerify(const ZZ& p, const ZZ& g, const ZZ& h, const ZZ& m, const ZZ& gamma, const ZZ& delta) {
+    CRYPTO_TIMED();
     ZZ left, right;
+    CRYPTO_COUNT_N(CTR_MODEXP, 3);
     left = (PowerMod(h, gamma, p)*PowerMod(gamma, delta, p)) % p;
     PowerMod(right, g, m, p);
     return (left==right);
     }
 
+// gamma, y^-1 and x * gamma depend only on the nonce, so they are computed while the message hashes
+void appliedCryptography::elGamalSignStream(const ZZ& p, const ZZ& g, const ZZ& x, const MessageSource& msg, ZZ& gamma, ZZ& delta) {
+    ZZ p1 = p - 1;
+    ZZ yinv, xg;
+    ZZ m = hashAlongside(msg, p1, [&] {
+        ZZ y = randomUnitNonce(p1);
+        CRYPTO_COUNT(CTR_MODEXP);
+        PowerMod(gamma, g, y, p);
+        yinv = InvMod(y, p1);
+        xg = (x * gamma) % p1;
+        zeroize(y);
+    });
+    delta = ((m - xg) * yinv) % p1;
+    if (delta < 0) delta += p1;
+    zeroize(yinv);
+    zeroize(xg);
+}
+
+// h^gamma * gamma^delta doesn't involve the message
+bool appliedCryptography::elGamalVerifyStream(const ZZ& p, const ZZ& g, const ZZ& h, const MessageSource& msg, const ZZ& gamma, const ZZ& delta) {
+    ZZ left;
+    CRYPTO_COUNT_N(CTR_MODEXP, 3);
+    ZZ m = hashAlongside(msg, p - 1, [&] {
+        left = (PowerMod(h, gamma, p) * PowerMod(gamma, delta, p)) % p;
+    });
+    return left == PowerMod(g, m, p);
+}
+
+// p = 2q + 1 with q prime and above 2^64, so the quadratic residues have no small subgroups.
+// The last answer is kept per thread: callers verify many batches in the same group.
+static bool batchableGroup(const ZZ& p) {
+    thread_local ZZ lastP;
+    thread_local bool lastOk = false;
+    if (p == lastP) return lastOk;
+    ZZ q = (p - 1) / 2;
+    lastOk = IsOdd(p) && NumBits(q) > 64 && ProbPrime(q) && ProbPrime(p);
+    lastP = p;
+    return lastOk;
+}
+
+// Batch verify with random 64-bit e_i: every signature in a set holds (up to ~2^-63) iff
+//   prod h_i^(e_i gamma_i) * gamma_i^(e_i delta_i) * g^(-sum e_i m_i) == 1 mod p,
+// one multiPower with exponents reduced mod p-1 and the terms of equal keys merged.
+// Error terms of small order could cancel across signatures whatever the weights, so this only
+// runs in safe-prime groups: each item first passes the equation on quadratic characters (Jacobi
+// symbols, no exponentiation), which leaves every error term in the prime order-(p-1)/2 subgroup.
+// Other primes are verified item by item. A failing set is split in half until single items remain.
+vector<bool> appliedCryptography::elGamalVerifyBatch(const ZZ& p, const ZZ& g, const vector<ElGamalSigItem>& items) {
+    CRYPTO_TIMED();
+    vector<bool> ok(items.size(), false);
+    ZZ p1 = p - 1;
+    ZZ gr = g % p;
+    if (IsZero(gr) || !batchableGroup(p)) {
+        for (size_t i = 0; i < items.size(); i++) {
+            const ElGamalSigItem& it = items[i];
+            ok[i] = elGamalVerify(p, g, it.h, it.m, it.gamma, it.delta);
+        }
+        return ok;
+    }
+
+    auto odd = [](long chi, const ZZ& e) { return chi < 0 && bit(e, 0); };
+    long chiG = Jacobi(gr, p);
+    vector<size_t> batch;
+    vector<ZZ> e(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+        const ElGamalSigItem& it = items[i];
+        ZZ hr = it.h % p, cr = it.gamma % p;
+        if (IsZero(hr) || IsZero(cr)) {
+            // non-units fall outside the group, check them as written
+            ok[i] = elGamalVerify(p, g, it.h, it.m, it.gamma, it.delta);
+            continue;
+        }
+        // chi(h)^gamma * chi(gamma)^delta == chi(g)^m, a necessary condition
+        if ((odd(Jacobi(hr, p), it.gamma) != odd(Jacobi(cr, p), it.delta)) != odd(chiG, it.m)) continue;
+        e[i] = conv<ZZ>(threadDRBG().next64() | 1);
+        batch.push_back(i);
+    }
+    if (batch.empty()) return ok;
+
+    ZZ_pPush push(p);
+    ZZ_p gp = conv<ZZ_p>(gr);
+    // batch equation over items idx[begin, end)
+    auto holds = [&](const size_t* idx, size_t n) {
+        vector<ZZ_p> bases;
+        vector<ZZ> exps;
+        map<ZZ, size_t> keyAt;
+        ZZ eg(0);
+        for (size_t k = 0; k < n; k++) {
+            const ElGamalSigItem& it = items[idx[k]];
+            const ZZ& ei = e[idx[k]];
+            ZZ hr = it.h % p;
+            auto slot = keyAt.find(hr);
+            if (slot == keyAt.end()) {
+                slot = keyAt.insert(make_pair(hr, bases.size())).first;
+                bases.push_back(conv<ZZ_p>(hr));
+                exps.push_back(ZZ(0));
+            }
+            exps[slot->second] = (exps[slot->second] + ei * it.gamma) % p1;
+            bases.push_back(conv<ZZ_p>(it.gamma % p));
+            exps.push_back((ei * it.delta) % p1);
+            eg = (eg + ei * it.m) % p1;
+        }
+        bases.push_back(gp);
+        exps.push_back((p1 - eg) % p1);
+        return IsOne(multiPower(bases, exps));
+    };
+    function<void(const size_t*, size_t)> settle = [&](const size_t* idx, size_t n) {
+        if (n == 1) {
+            const ElGamalSigItem& it = items[idx[0]];
+            ok[idx[0]] = elGamalVerify(p, g, it.h, it.m, it.gamma, it.delta);
+            return;
+        }
+        if (holds(idx, n)) {
+            for (size_t k = 0; k < n; k++) ok[idx[k]] = true;
+            return;
+        }
+        settle(idx, n / 2);
+        settle(idx + n / 2, n - n / 2);
+    };
+    settle(batch.data(), batch.size());
+    return ok;
+}
+
 
 
     // Elliptic curve 
+// secp256k1's group order, so initCurve sets GLV up for it without being given n
+static const char* const SECP256K1_ORDER = "115792089237316195423570985008687907852837564279074904382605163141518161494337";
+
 void appliedCryptography::initCurve(const ZZ& _pECC, const ZZ_p& _aECC, const ZZ_p& _bECC) {
     pECC = _pECC;
-    ZZ_p::init(pECC);    // set modulus
+    curveCtx = ZZ_pContext(pECC);
+    curveCtx.restore();  // also set the calling thread's modulus so it can build points
     aECC = _aECC;
     bECC = _bECC;
+    curveSqrt = ModSqrt(pECC);
+    selectFieldBackend();
+    glvAvailable = false;
+    clear(orderECC);
+    primeOrderCurve = false;
+    if (pECC == Fp256<Secp256k1Field>::modulus() && IsZero(aECC) && bECC == 7) {
+        ZZ n = conv<ZZ>(SECP256K1_ORDER);
+        setCurveOrder(n);
+        setupGLV(n);
+    }
+}
+
+void appliedCryptography::initCurve(const ZZ& _pECC, const ZZ_p& _aECC, const ZZ_p& _bECC, const ZZ& order) {
+    initCurve(_pECC, _aECC, _bECC);
+    if (orderECC == order) return;
+    setCurveOrder(order);
+    setupGLV(order);
+}
+
+// The key group is the whole curve when n is prime, n P = O for some point P (so n divides the
+// number of points) and 2n exceeds the Hasse bound p + 1 + 2 sqrt(p) (so n is that number)
+void appliedCryptography::setCurveOrder(const ZZ& n) {
+    orderECC = n;
+    primeOrderCurve = false;
+    if (2 * n <= pECC + 1 + 2 * (SqrRoot(pECC) + 1) || !ProbPrime(n)) return;
+    ZZ_pPush push(curveCtx);
+    primeOrderCurve = scalarMultiply(curvePoint(), n).isInfinity;
+}
+
+ECPoint appliedCryptography::curvePoint() {
+    ZZ_pPush push(curveCtx);
+    ECPoint P;
+    for (long x = 1; P.isInfinity; x++) {
+        ZZ_p X = conv<ZZ_p>(x), Y;
+        if (curveSqrt(Y, (sqr(X) + aECC) * X + bECC) && !IsZero(Y)) P = ECPoint(X, Y);
+    }
+    return P;
+}
+
+// GLV: with a = 0 and p = 1 mod 3, phi(x, y) = (beta x, y) for a cube root of unity beta is an
+// endomorphism, and on a group of prime order n it is multiplication by a cube root of unity lambda
+// mod n. Which lambda goes with which beta is read off one point. Only set up when the curve itself
+// has prime order n (setCurveOrder), so every point has order n.
+void appliedCryptography::setupGLV(const ZZ& n) {
+    glvAvailable = false;
+    if (!IsZero(aECC) || pECC % 3 != 1 || n % 3 != 1 || !primeOrderCurve || n != orderECC) return;
+    ZZ_pPush push(curveCtx);
+
+    ZZ_p beta;
+    for (long g = 2; IsOne(beta = power(conv<ZZ_p>(g), (pECC - 1) / 3)); g++) {}
+    ZZ lambda;
+    for (long g = 2; IsOne(lambda = PowerMod(ZZ(g), (n - 1) / 3, n)); g++) {}
+
+    ECPoint P = curvePoint();
+    ECPoint L = scalarMultiply(P, lambda);
+    if (L.isInfinity || L.y != P.y) return;
+    if (L.x != beta * P.x) {
+        beta = sqr(beta);
+        if (L.x != beta * P.x) return;
+    }
+
+    // Extended Euclid on (n, lambda) keeps r_i = t_i lambda (mod n), so each (r_i, -t_i) is in the
+    // lattice; the short basis is taken around the first remainder below sqrt(n)
+    ZZ root = SqrRoot(n);
+    ZZ r0 = n, r1 = lambda, t0(0), t1(1), q, t;
+    while (r1 >= root) {
+        q = r0 / r1;
+        t = r0 - q * r1;
+        r0 = r1;
+        r1 = t;
+        t = t0 - q * t1;
+        t0 = t1;
+        t1 = t;
+    }
+    glv.a1 = r1;
+    glv.b1 = -t1;
+    q = r0 / r1;
+    ZZ r2 = r0 - q * r1, t2 = t0 - q * t1;
+    if (sqr(r0) + sqr(t0) <= sqr(r2) + sqr(t2)) {
+        glv.a2 = r0;
+        glv.b2 = -t0;
+    } else {
+        glv.a2 = r2;
+        glv.b2 = -t2;
+    }
+
+    glv.n = n;
+    glv.beta = beta;
+    glv.lambda = lambda;
+    glv.shift = NumBits(n) + 16;
+    glv.g1 = ((abs(glv.b2) << glv.shift) + n / 2) / n;
+    glv.g2 = ((abs(glv.b1) << glv.shift) + n / 2) / n;
+    glv.neg1 = glv.b2 < 0;
+    glv.neg2 = glv.b1 > 0;
+    glvAvailable = true;
 }
 
 // Point negation: returns -P
 ECPoint appliedCryptography::pointNeg(const ECPoint& P) {
+    ZZ_pPush push(curveCtx);      // this curve's modulus, caller's is restored on return
     if (P.isInfinity) return P;
     return ECPoint(P.x, -P.y);    // -y (NTL handles mod p)
 }
 
 // Point addition (uses class aECC implicitly in doubling if needed)
 ECPoint appliedCryptography::pointAdd(const ECPoint& P, const ECPoint& Q) {
+    ZZ_pPush push(curveCtx);
     if (P.isInfinity) return Q;
     if (Q.isInfinity) return P;
 
@@ -288,6 +571,9 @@ ECPoint appliedCryptography::pointAdd(const ECPoint& P, const ECPoint& Q) {
     ZZ_p num = Q.y - P.y;
     ZZ_p den = Q.x - P.x;
     ZZ_p lambda = num * inv(den);  // inv from NTL
+    CRYPTO_COUNT(CTR_POINT_ADD);
+    CRYPTO_COUNT(CTR_FIELD_INV);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 3);
 
     ZZ_p x3 = lambda * lambda - P.x - Q.x;
     ZZ_p y3 = lambda * (P.x - x3) - P.y;
@@ -297,6 +583,7 @@ ECPoint appliedCryptography::pointAdd(const ECPoint& P, const ECPoint& Q) {
 
 // Point doubling
 ECPoint appliedCryptography::pointDouble(const ECPoint& P) {
+    ZZ_pPush push(curveCtx);
     if (P.isInfinity) return P;
 
     // If y == 0 => slope infinite, result = point at infinity
@@ -305,6 +592,9 @@ ECPoint appliedCryptography::pointDouble(const ECPoint& P) {
     ZZ_p num = ZZ_p(3) * P.x * P.x + aECC;   // 3*x^2 + a
     ZZ_p den = ZZ_p(2) * P.y;                // 2*y
     ZZ_p lambda = num * inv(den);
+    CRYPTO_COUNT(CTR_POINT_DOUBLE);
+    CRYPTO_COUNT(CTR_FIELD_INV);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 7);
 
     ZZ_p x3 = lambda * lambda - ZZ_p(2) * P.x;
     ZZ_p y3 = lambda * (P.x - x3) - P.y;
@@ -312,63 +602,686 @@ ECPoint appliedCryptography::pointDouble(const ECPoint& P) {
     return ECPoint(x3, y3);
 }
 
-// Scalar multiplication (double-and-add, MSB-first)
+// In-place affine addition and doubling: same formulas, registers from the thread arena
+void appliedCryptography::pointAddInto(ECPoint& out, const ECPoint& P, const ECPoint& Q) {
+    ZZ_pPush push(curveCtx);
+    if (P.isInfinity) {
+        out = Q;
+        return;
+    }
+    if (Q.isInfinity) {
+        out = P;
+        return;
+    }
+    if (P.x == Q.x) {
+        if (P.y == Q.y) pointDoubleInto(out, P);
+        else out.isInfinity = true;
+        return;
+    }
+
+    CRYPTO_COUNT(CTR_POINT_ADD);
+    CRYPTO_COUNT(CTR_FIELD_INV);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 2);
+    CRYPTO_COUNT(CTR_FIELD_SQR);
+    ECScratch<ZZ_p>& s = ecThreadArena<ZZ_p>().s;
+    sub(s.A, Q.x, P.x);
+    inv(s.A, s.A);
+    sub(s.B, Q.y, P.y);
+    mul(s.C, s.B, s.A);                     // lambda
+    sqr(s.D, s.C);
+    sub(s.D, s.D, P.x);
+    sub(s.D, s.D, Q.x);                     // x3
+    sub(s.E, P.x, s.D);
+    mul(s.E, s.C, s.E);
+    sub(out.y, s.E, P.y);
+    out.x = s.D;
+    out.isInfinity = false;
+}
+
+void appliedCryptography::pointDoubleInto(ECPoint& out, const ECPoint& P) {
+    ZZ_pPush push(curveCtx);
+    if (P.isInfinity || IsZero(P.y)) {
+        out.isInfinity = true;
+        return;
+    }
+
+    CRYPTO_COUNT(CTR_POINT_DOUBLE);
+    CRYPTO_COUNT(CTR_FIELD_INV);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 2);
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 2);
+    ECScratch<ZZ_p>& s = ecThreadArena<ZZ_p>().s;
+    sqr(s.A, P.x);
+    add(s.B, s.A, s.A);
+    add(s.B, s.B, s.A);
+    add(s.B, s.B, aECC);                    // 3*x^2 + a
+    add(s.A, P.y, P.y);
+    inv(s.A, s.A);
+    mul(s.C, s.B, s.A);                     // lambda
+    sqr(s.D, s.C);
+    sub(s.D, s.D, P.x);
+    sub(s.D, s.D, P.x);                     // x3
+    sub(s.E, P.x, s.D);
+    mul(s.E, s.C, s.E);
+    sub(out.y, s.E, P.y);
+    out.x = s.D;
+    out.isInfinity = false;
+}
+
+ECPointJ appliedCryptography::toJacobian(const ECPoint& P) {
+    ZZ_pPush push(curveCtx);
+    return ecToJacobian(P);
+}
+
+// Jacobian -> affine, the only inversion of a scalar multiplication
+ECPoint appliedCryptography::toAffine(const ECPointJ& P) {
+    ZZ_pPush push(curveCtx);
+    return ecToAffine(P);
+}
+
+ECPointJ appliedCryptography::jacobianDouble(const ECPointJ& P) {
+    ZZ_pPush push(curveCtx);
+    return ecDouble(P, aECC);
+}
+
+ECPointJ appliedCryptography::jacobianAdd(const ECPointJ& P, const ECPointJ& Q) {
+    ZZ_pPush push(curveCtx);
+    return ecAdd(P, Q, aECC);
+}
+
+ECPointJ appliedCryptography::jacobianAddMixed(const ECPointJ& P, const ECPoint& Q) {
+    ZZ_pPush push(curveCtx);
+    return ecAddMixed(P, Q, aECC);
+}
+
+// Normalize many Jacobian points with one inversion (Montgomery's trick)
+vector<ECPoint> appliedCryptography::normalizeBatch(const vector<ECPointJ>& pts) {
+    ZZ_pPush push(curveCtx);
+    return ecNormalizeBatch(pts);
+}
+
+void appliedCryptography::setWindowWidth(long w) {
+    if (w < 2 || w > 8) {
+        throw runtime_error("wNAF window width must be between 2 and 8");
+    }
+    wnafWidth = w;
+}
+
+// wNAF recoding: k = sum d_i 2^i
+vector<long> wnafDigits(const ZZ& k, long w) {
+    vector<long> digits;
+    wnafDigits(digits, k, w);
+    return digits;
+}
+
+void wnafDigits(vector<long>& digits, const ZZ& k, long w) {
+    digits.clear();
+    digits.reserve(NumBits(k) + 1);
+    long full = 1L << w;
+    long half = 1L << (w - 1);
+
+    thread_local ZZ t;
+    abs(t, k);
+    while (t > 0) {
+        long d = 0;
+        if (IsOdd(t)) {
+            d = trunc_long(t, w);           // t mod 2^w
+            if (d >= half) d -= full;       // signed residue
+            t -= d;
+        }
+        digits.push_back(sign(k) < 0 ? -d : d);
+        t >>= 1;
+    }
+}
+
+// Affine table P, 3P, 5P, ..., (2^(w-1) - 1)P
+vector<ECPoint> appliedCryptography::oddMultiples(const ECPoint& P, long w) {
+    ZZ_pPush push(curveCtx);
+    return ecOddMultiples(P, w, aECC);
+}
+
+// ZZ_p <-> Fp256 conversions for the fixed-width backends
+template<class Params>
+static AffinePoint<Fp256<Params>> toFixedWidth(const ECPoint& P) {
+    if (P.isInfinity) return AffinePoint<Fp256<Params>>();
+    return AffinePoint<Fp256<Params>>(Fp256<Params>::fromZZ(rep(P.x)), Fp256<Params>::fromZZ(rep(P.y)));
+}
+
+template<class Params>
+static ECPointJ fromFixedWidth(const JacobianPoint<Fp256<Params>>& P) {
+    if (P.isInfinity()) return ECPointJ();
+    return ECPointJ(conv<ZZ_p>(P.X.toZZ()), conv<ZZ_p>(P.Y.toZZ()), conv<ZZ_p>(P.Z.toZZ()));
+}
+
+// Curve points and constants in field F
+template<class F>
+static AffinePoint<F> toField(const ECPoint& P) {
+    if (P.isInfinity) return AffinePoint<F>();
+    return AffinePoint<F>(F::fromZZ(rep(P.x)), F::fromZZ(rep(P.y)));
+}
+
+template<>
+AffinePoint<ZZ_p> toField<ZZ_p>(const ECPoint& P) {
+    return P;
+}
+
+template<class F>
+static F curveConstant(const ZZ_p& a) {
+    return F::fromZZ(rep(a));
+}
+
+template<>
+ZZ_p curveConstant<ZZ_p>(const ZZ_p& a) {
+    return a;
+}
+
+static ECPointJ toCurveJ(const ECPointJ& P) {
+    return P;
+}
+
+template<class Params>
+static ECPointJ toCurveJ(const JacobianPoint<Fp256<Params>>& P) {
+    return fromFixedWidth<Params>(P);
+}
+
+template<class Params>
+static ECPointJ fixedWidthMultiply(const ECPoint& P, const vector<long>& naf, long w, const ZZ_p& a) {
+    typedef Fp256<Params> F;
+    return fromFixedWidth<Params>(ecWnafMultiply(toFixedWidth<Params>(P), naf, w, F::fromZZ(rep(a))));
+}
+
+template<class Params>
+static ECPointJ fixedWidthMultiply2(const ECPoint& P, const vector<long>& nafA, const ECPoint& Q,
+                                    const vector<long>& nafB, long w, const ZZ_p& a) {
+    typedef Fp256<Params> F;
+    return fromFixedWidth<Params>(ecWnafMultiply2(toFixedWidth<Params>(P), nafA, toFixedWidth<Params>(Q), nafB,
+                                                  w, F::fromZZ(rep(a))));
+}
+
+// r = a^((p+1)/4) in the fixed-width field, false when a is a non-residue
+template<class Params>
+static bool fixedWidthSqrt(ZZ_p& r, const ZZ_p& a, const ExpRecoding& e) {
+    typedef Fp256<Params> F;
+    F x = F::fromZZ(rep(a));
+    F y = recodedPower(x, e);
+    if (sqr(y) != x) return false;
+    r = conv<ZZ_p>(y.toZZ());
+    return true;
+}
+
+template<class Params>
+static bool fixedWidthLadderX(const ECPoint& P, const vector<char>& bits, const ZZ_p& a, ZZ& x) {
+    typedef Fp256<Params> F;
+    F xF;
+    ECArena<F> A;       // on the stack, so the ladder registers can stay in CPU registers
+    if (!ecCoZLadderX(toFixedWidth<Params>(P), bits, F::fromZZ(rep(a)), xF, A)) return false;
+    x = xF.toZZ();
+    return true;
+}
+
+void appliedCryptography::selectFieldBackend() {
+    if (keyCache) keyCache = make_shared<TableCache<KeyTable>>(keyCache->capacity(), keyCache->buildAfter());
+    fieldBackend = FIELD_GENERIC;
+    if (!fixedWidthEnabled) return;
+    if (pECC == Fp256<P256Field>::modulus()) fieldBackend = FIELD_P256;
+    else if (pECC == Fp256<Secp256k1Field>::modulus()) fieldBackend = FIELD_SECP256K1;
+}
+
+void appliedCryptography::useFixedWidthField(bool enable) {
+    fixedWidthEnabled = enable;
+    selectFieldBackend();
+}
+
+// c = round(k g / 2^shift), negated when neg
+static void glvRound(ZZ& c, const ZZ& k, const ZZ& g, long shift, bool neg) {
+    mul(c, k, g);
+    c >>= shift - 1;
+    c += 1;
+    c >>= 1;
+    if (neg) NTL::negate(c, c);
+}
+
+// c1 = round(b2 k / n), c2 = round(-b1 k / n) through the precomputed 2^shift / n multiples, which can
+// be off by one; that only lengthens k1 and k2 by a bit. Then (k1, k2) = (k, 0) - c1 (a1, b1) - c2 (a2, b2).
+void appliedCryptography::glvSplit(vector<long>& naf1, vector<long>& naf2, const ZZ& k) const {
+    thread_local ZZ kr, c1, c2, t, k1, k2;
+    rem(kr, k, glv.n);
+    glvRound(c1, kr, glv.g1, glv.shift, glv.neg1);
+    glvRound(c2, kr, glv.g2, glv.shift, glv.neg2);
+    mul(t, c1, glv.a1);
+    sub(k1, kr, t);
+    mul(t, c2, glv.a2);
+    sub(k1, k1, t);
+    mul(t, c1, glv.b1);
+    mul(k2, c2, glv.b2);
+    add(k2, k2, t);
+    NTL::negate(k2, k2);
+    wnafDigits(naf1, k1, wnafWidth);
+    wnafDigits(naf2, k2, wnafWidth);
+}
+
+// Tables of P and phi(P) for every point, phi's mapped from P's
+template<class F>
+static ECPointJ glvMultiplyJ(const ECPoint* pts, size_t n, const vector<vector<long>>& nafs, long w,
+                             const ZZ_p& curveA, const ZZ_p& curveBeta) {
+    F a = curveConstant<F>(curveA), beta = curveConstant<F>(curveBeta);
+    vector<vector<AffinePoint<F>>> tables;
+    tables.reserve(2 * n);
+    for (size_t i = 0; i < n; i++) {
+        tables.push_back(ecOddMultiples(toField<F>(pts[i]), w, a));
+        vector<AffinePoint<F>> phi = ecEndomorphismTable(tables.back(), beta);
+        tables.push_back(move(phi));
+    }
+    return toCurveJ(ecWnafMultiplyMany(tables, nafs, a));
+}
+
+ECPointJ appliedCryptography::glvMultiplyJ(const ECPoint* pts, const ZZ* ks, size_t n) {
+    vector<vector<long>> nafs(2 * n);
+    for (size_t i = 0; i < n; i++) glvSplit(nafs[2 * i], nafs[2 * i + 1], ks[i]);
+    switch (fieldBackend) {
+    case FIELD_P256:      return ::glvMultiplyJ<Fp256<P256Field>>(pts, n, nafs, wnafWidth, aECC, glv.beta);
+    case FIELD_SECP256K1: return ::glvMultiplyJ<Fp256<Secp256k1Field>>(pts, n, nafs, wnafWidth, aECC, glv.beta);
+    default:              return ::glvMultiplyJ<ZZ_p>(pts, n, nafs, wnafWidth, aECC, glv.beta);
+    }
+}
+
+// Scalar multiplication in Jacobian coordinates (wNAF, MSB-first)
+ECPointJ appliedCryptography::scalarMultiplyJ(const ECPoint& P, const ZZ& k) {
+    ZZ_pPush push(curveCtx);
+    if (P.isInfinity || k == 0) return ECPointJ();
+    if (glvInUse()) return glvMultiplyJ(&P, &k, 1);
+
+    vector<long> naf = wnafDigits(k, wnafWidth);
+    switch (fieldBackend) {
+    case FIELD_P256:      return fixedWidthMultiply<P256Field>(P, naf, wnafWidth, aECC);
+    case FIELD_SECP256K1: return fixedWidthMultiply<Secp256k1Field>(P, naf, wnafWidth, aECC);
+    default:              return ecWnafMultiply(P, naf, wnafWidth, aECC);
+    }
+}
+
+// Interleaved wNAF: both digit strings share the doublings
+ECPointJ appliedCryptography::multiScalarMultiplyJ(const ECPoint& P, const ZZ& a, const ECPoint& Q, const ZZ& b) {
+    ZZ_pPush push(curveCtx);
+    if (P.isInfinity || a == 0) return scalarMultiplyJ(Q, b);
+    if (Q.isInfinity || b == 0) return scalarMultiplyJ(P, a);
+    if (glvInUse()) {
+        ECPoint pts[2] = { P, Q };
+        ZZ ks[2] = { a, b };
+        return glvMultiplyJ(pts, ks, 2);
+    }
+
+    vector<long> nafA = wnafDigits(a, wnafWidth);
+    vector<long> nafB = wnafDigits(b, wnafWidth);
+    switch (fieldBackend) {
+    case FIELD_P256:      return fixedWidthMultiply2<P256Field>(P, nafA, Q, nafB, wnafWidth, aECC);
+    case FIELD_SECP256K1: return fixedWidthMultiply2<Secp256k1Field>(P, nafA, Q, nafB, wnafWidth, aECC);
+    default:              return ecWnafMultiply2(P, nafA, Q, nafB, wnafWidth, aECC);
+    }
+}
+
+ECPoint appliedCryptography::multiScalarMultiply(const ECPoint& P, const ZZ& a, const ECPoint& Q, const ZZ& b) {
+    CRYPTO_TIMED();
+    ZZ_pPush push(curveCtx);
+    return toAffine(multiScalarMultiplyJ(P, a, Q, b));
+}
+
+// Scalar multiplication, one inversion at the end
 ECPoint appliedCryptography::scalarMultiply(const ECPoint& P, const ZZ& k) {
-    if (P.isInfinity) return P;
-    if (k == 0) return ECPoint();
-
-    ECPoint R;         // starts as point at infinity
-    // Q not needed to change; we add P when bit==1
-    long n = NumBits(k);
-    for (long i = n - 1; i >= 0; --i) {
-        // double R every iteration
-        R = pointDouble(R);
-        if (bit(k, i)) {
-            R = pointAdd(R, P);
+    ECPoint R;
+    scalarMultiplyInto(R, P, k);
+    return R;
+}
+
+// Fixed-width wNAF on the per-thread arena, converted back into out's coordinates; with naf2 the GLV
+// split naf * P + naf2 * phi(P)
+template<class Params>
+static void fixedWidthMultiplyInto(ECPoint& out, const ECPoint& P, const vector<long>& naf, const vector<long>* naf2,
+                                   long w, const ZZ_p& a, const ZZ_p& beta) {
+    typedef Fp256<Params> F;
+    ECArena<F>& A = ecThreadArena<F>();
+    JacobianPoint<F> R;
+    AffinePoint<F> RA;
+    if (naf2) ecGlvMultiplyInto(R, toFixedWidth<Params>(P), naf, *naf2, w, F::fromZZ(rep(a)), F::fromZZ(rep(beta)), A);
+    else ecWnafMultiplyInto(R, toFixedWidth<Params>(P), naf, w, F::fromZZ(rep(a)), A);
+    ecToAffineInto(RA, R, A.s);
+    out.isInfinity = RA.isInfinity;
+    if (RA.isInfinity) return;
+    thread_local ZZ t;
+    RA.x.toZZ(t);
+    conv(out.x, t);
+    RA.y.toZZ(t);
+    conv(out.y, t);
+}
+
+void appliedCryptography::scalarMultiplyInto(ECPoint& out, const ECPoint& P, const ZZ& k) {
+    CRYPTO_TIMED();
+    ZZ_pPush push(curveCtx);
+    if (P.isInfinity || IsZero(k)) {
+        out.isInfinity = true;
+        return;
+    }
+    thread_local vector<long> naf, naf2;
+    const vector<long>* second = nullptr;
+    if (glvInUse()) {
+        glvSplit(naf, naf2, k);
+        second = &naf2;
+    } else {
+        wnafDigits(naf, k, wnafWidth);
+    }
+    switch (fieldBackend) {
+    case FIELD_P256:      fixedWidthMultiplyInto<P256Field>(out, P, naf, second, wnafWidth, aECC, glv.beta); break;
+    case FIELD_SECP256K1: fixedWidthMultiplyInto<Secp256k1Field>(out, P, naf, second, wnafWidth, aECC, glv.beta); break;
+    default: {
+        ECArena<ZZ_p>& A = ecThreadArena<ZZ_p>();
+        thread_local ECPointJ R;
+        if (second) ecGlvMultiplyInto(R, P, naf, naf2, wnafWidth, aECC, glv.beta, A);
+        else ecWnafMultiplyInto(R, P, naf, wnafWidth, aECC, A);
+        ecToAffineInto(out, R, A.s);
+    }
+    }
+}
+
+// Fixed-base table: window i holds 1..2^w-1 times B_i = 2^(w*i) G
+FixedBaseTable appliedCryptography::precomputeFixedBase(const ECPoint& G, const ZZ& q, long w) {
+    ZZ_pPush push(curveCtx);
+    if (w < 1 || w > 8) {
+        throw runtime_error("fixed-base window width must be between 1 and 8");
+    }
+    FixedBaseTable T;
+    T.G = G;
+    T.q = q;
+    T.w = w;
+
+    long windows = (NumBits(q) + w - 1) / w;
+    long perRow = (1L << w) - 1;
+
+    vector<ECPoint> flat = ecCombTable(G, windows, w, aECC);
+    T.rows.resize(windows);
+    for (long i = 0; i < windows; i++) {
+        T.rows[i].assign(flat.begin() + i * perRow, flat.begin() + (i + 1) * perRow);
+    }
+    return T;
+}
+
+// k*G from the table: sum of rows[i][digit_i], additions only
+ECPointJ appliedCryptography::fixedBaseMultiplyJ(const FixedBaseTable& T, const ZZ& k) {
+    ZZ_pPush push(curveCtx);
+    ZZ e = k;
+    if (e < 0 || NumBits(e) > T.w * (long)T.rows.size()) e = e % T.q;
+
+    ECPointJ R;
+    long windows = (NumBits(e) + T.w - 1) / T.w;
+    for (long i = 0; i < windows; i++) {
+        long d = 0;
+        for (long b = T.w - 1; b >= 0; b--) {
+            d = 2 * d + bit(e, i * T.w + b);
         }
+        if (d != 0) R = ecAddMixed(R, T.rows[i][d - 1], aECC);
     }
     return R;
 }
 
+ECPoint appliedCryptography::fixedBaseMultiply(const FixedBaseTable& T, const ZZ& k) {
+    CRYPTO_TIMED();
+    ZZ_pPush push(curveCtx);
+    return toAffine(fixedBaseMultiplyJ(T, k));
+}
+
+// Public-key cache: the comb of one key in the backend it was built for; only that tuple slot is filled
+struct KeyTable {
+    FieldBackend backend = FIELD_GENERIC;
+    long w = 0;
+    long windows = 0;
+    size_t footprint = 0;
+    tuple<vector<ECPoint>, vector<AffinePoint<Fp256<P256Field>>>, vector<AffinePoint<Fp256<Secp256k1Field>>>> rows;
+
+    size_t bytes() const { return footprint; }
+};
+
+// Base-2^w digits of k >= 0, least significant first
+static void combDigits(vector<long>& digits, const ZZ& k, long w) {
+    long windows = (NumBits(k) + w - 1) / w;
+    digits.assign(windows, 0);
+    for (long i = 0; i < windows; i++) {
+        long d = 0;
+        for (long b = w - 1; b >= 0; b--) d = 2 * d + bit(k, i * w + b);
+        digits[i] = d;
+    }
+}
+
+static bool combFits(const KeyTable& T, const ZZ& k) {
+    return sign(k) >= 0 && NumBits(k) <= T.w * T.windows;
+}
+
+// Fp256 points sit inline; ZZ_p coordinates add their heap limbs
+template<class F>
+static void buildComb(KeyTable& T, const ECPoint& P, const ZZ_p& a, size_t heapPerPoint) {
+    vector<AffinePoint<F>>& rows = get<vector<AffinePoint<F>>>(T.rows);
+    rows = ecCombTable(toField<F>(P), T.windows, T.w, curveConstant<F>(a));
+    T.footprint = sizeof(KeyTable) + rows.size() * (sizeof(AffinePoint<F>) + heapPerPoint);
+}
+
+// a*A + b*B from two combs in F, B optional
+template<class F>
+static ECPointJ combMultiplyJ(const KeyTable& A, const ZZ& a, const KeyTable* B, const ZZ& b, const ZZ_p& curveA) {
+    F fa = curveConstant<F>(curveA);
+    thread_local vector<long> digits;
+    combDigits(digits, a, A.w);
+    JacobianPoint<F> R = ecCombMultiply(get<vector<AffinePoint<F>>>(A.rows), digits, A.w, fa);
+    if (B) {
+        combDigits(digits, b, B->w);
+        R = ecAdd(R, ecCombMultiply(get<vector<AffinePoint<F>>>(B->rows), digits, B->w, fa), fa);
+    }
+    return toCurveJ(R);
+}
+
+static ECPointJ combMultiplyJ(const KeyTable& A, const ZZ& a, const KeyTable* B, const ZZ& b, const ZZ_p& curveA) {
+    switch (A.backend) {
+    case FIELD_P256:      return combMultiplyJ<Fp256<P256Field>>(A, a, B, b, curveA);
+    case FIELD_SECP256K1: return combMultiplyJ<Fp256<Secp256k1Field>>(A, a, B, b, curveA);
+    default:              return combMultiplyJ<ZZ_p>(A, a, B, b, curveA);
+    }
+}
+
+void appliedCryptography::enableKeyCache(size_t capacity, uint64_t buildAfter, long w) {
+    if (w < 1 || w > 8) {
+        throw runtime_error("key cache window width must be between 1 and 8");
+    }
+    keyCacheWidth = w;
+    keyCache = capacity > 0 ? make_shared<TableCache<KeyTable>>(capacity, buildAfter) : nullptr;
+}
+
+void appliedCryptography::disableKeyCache() {
+    keyCache.reset();
+}
+
+CacheStats appliedCryptography::keyCacheStats() const {
+    return keyCache ? keyCache->stats() : CacheStats();
+}
+
+// Keyed by the compressed encoding; scalars below about p + 2 sqrt(p) fit the comb
+shared_ptr<const KeyTable> appliedCryptography::keyTable(const ECPoint& P) {
+    if (!keyCache || P.isInfinity) return nullptr;
+    ZZ_pPush push(curveCtx);
+    string key(pointBytes(true), '\0');
+    encodePoint(P, (unsigned char*)&key[0], true);
+    return keyCache->lookup(key, [&] {
+        shared_ptr<KeyTable> T = make_shared<KeyTable>();
+        T->backend = fieldBackend;
+        T->w = keyCacheWidth;
+        T->windows = (NumBits(pECC) + 1 + T->w - 1) / T->w;
+        switch (fieldBackend) {
+        case FIELD_P256:      buildComb<Fp256<P256Field>>(*T, P, aECC, 0); break;
+        case FIELD_SECP256K1: buildComb<Fp256<Secp256k1Field>>(*T, P, aECC, 0); break;
+        default:              buildComb<ZZ_p>(*T, P, aECC, 2 * (16 + ((fieldBytes() + 7) & ~7L)));
+        }
+        return shared_ptr<const KeyTable>(T);
+    });
+}
+
+ECPointJ appliedCryptography::cachedScalarMultiplyJ(const ECPoint& P, const ZZ& k) {
+    ZZ_pPush push(curveCtx);
+    shared_ptr<const KeyTable> T = keyTable(P);
+    if (T && combFits(*T, k)) return combMultiplyJ(*T, k, nullptr, k, aECC);
+    return scalarMultiplyJ(P, k);
+}
+
+// Both combs or neither: one cached point alone costs about what the joint wNAF chain does
+ECPointJ appliedCryptography::cachedMultiScalarMultiplyJ(const ECPoint& P, const ZZ& a, const ECPoint& Q, const ZZ& b) {
+    ZZ_pPush push(curveCtx);
+    shared_ptr<const KeyTable> TP = keyTable(P), TQ = keyTable(Q);
+    if (TP && TQ && combFits(*TP, a) && combFits(*TQ, b)) return combMultiplyJ(*TP, a, TQ.get(), b, aECC);
+    return multiScalarMultiplyJ(P, a, Q, b);
+}
+
+// y^2 == x^3 + a x + b; infinity counts as on the curve
+bool appliedCryptography::isOnCurve(const ECPoint& P) {
+    ZZ_pPush push(curveCtx);
+    if (P.isInfinity) return true;
+    return sqr(P.y) == (sqr(P.x) + aECC) * P.x + bECC;
+}
+
+// Uniform in [1, q-1]; each zero drawn counts as a retry
+static ZZ randomNonzero(const ZZ& q) {
+    ZZ y = threadDRBG().randomBnd(q);
+    while (IsZero(y)) {
+        CRYPTO_COUNT(CTR_RNG_RETRY);
+        y = threadDRBG().randomBnd(q);
+    }
+    return y;
+}
+
 // Key generation: choose priv in [1, q-1], compute Q = priv * G
 void appliedCryptography::keyGen(const ECPoint& G, const ZZ& q, ZZ& priv, ECPoint& Q) {
-    do {
-        priv = RandomBnd(q);   // 0..q-1
-    } while (priv == 0);
+    ZZ_pPush push(curveCtx);
+    priv = randomNonzero(q);
     Q = scalarMultiply(G, priv);
 }
 
+void appliedCryptography::keyGen(const FixedBaseTable& G, ZZ& priv, ECPoint& Q) {
+    ZZ_pPush push(curveCtx);
+    priv = randomNonzero(G.q);
+    Q = fixedBaseMultiply(G, priv);
+}
+
 // EC-ElGamal: C1 = yG, C2 = M + yQ
 pair<ECPoint, ECPoint> appliedCryptography::elgamalEncryptEC(const ECPoint& M, const ECPoint& G, const ECPoint& Q, const ZZ& q) {
-    ZZ y;
-    do {
-        y = RandomBnd(q);
-    } while (y == 0);
+    CRYPTO_TIMED();
+    ZZ_pPush push(curveCtx);
+    ZZ y = randomNonzero(q);
+
+    ECPoint C1 = keyCache ? toAffine(cachedScalarMultiplyJ(G, y)) : scalarMultiply(G, y);
+    ECPointJ yQ = cachedScalarMultiplyJ(Q, y);
+    ECPoint C2 = toAffine(jacobianAddMixed(yQ, M));
+    return make_pair(C1, C2);
+}
+
+pair<ECPoint, ECPoint> appliedCryptography::elgamalEncryptEC(const ECPoint& M, const FixedBaseTable& G, const ECPoint& Q) {
+    CRYPTO_TIMED();
+    ZZ_pPush push(curveCtx);
+    ZZ y = randomNonzero(G.q);
 
-    ECPoint C1 = scalarMultiply(G, y);
-    ECPoint yQ = scalarMultiply(Q, y);
-    ECPoint C2 = pointAdd(M, yQ);
+    ECPoint C1 = fixedBaseMultiply(G, y);
+    ECPointJ yQ = cachedScalarMultiplyJ(Q, y);
+    ECPoint C2 = toAffine(jacobianAddMixed(yQ, M));
     return make_pair(C1, C2);
 }
 
 // EC-ElGamal decrypt: M = C2 - priv*C1
 ECPoint appliedCryptography::elgamalDecryptEC(const pair<ECPoint, ECPoint>& C, const ZZ& priv) {
-    ECPoint mC1 = scalarMultiply(C.first, priv);  // priv * C1
-    ECPoint neg = pointNeg(mC1);
-    ECPoint M = pointAdd(C.second, neg);
+    CRYPTO_TIMED();
+    ZZ_pPush push(curveCtx);
+    ECPointJ neg = scalarMultiplyJ(C.first, priv);  // priv * C1
+    neg.Y = -neg.Y;
+    ECPoint M = toAffine(jacobianAddMixed(neg, C.second));
     return M;
 }
 
+ECElGamalEncryptor::ECElGamalEncryptor(appliedCryptography& crypto, const FixedBaseTable& G, const ECPoint& Q)
+    : crypto(&crypto), G(make_shared<const FixedBaseTable>(G)), Q(Q) {}
+
+// ECDH shared secret: only x of priv * peer leaves the ladder
+// k = priv mod q lifted to k + q or k + 2q, whichever has bit NumBits(q) set: same point, and a
+// ladder length that depends on q only. Reducing mod q is only sound for peers of order dividing q,
+// which off a prime-order curve takes a check q * peer = O.
+ZZ appliedCryptography::ecdhSharedSecret(const ZZ& priv, const ECPoint& peer) {
+    CRYPTO_TIMED();
+    ZZ_pPush push(curveCtx);
+    const ZZ& q = orderECC;
+    if (q <= 1) throw runtime_error("ecdhSharedSecret: group order unknown, pass it to initCurve");
+    if (priv <= 0) throw runtime_error("ecdhSharedSecret: private key must be positive");
+    if (peer.isInfinity || !isOnCurve(peer)) throw runtime_error("ecdhSharedSecret: invalid peer point");
+    if (!primeOrderCurve && !scalarMultiply(peer, q).isInfinity) {
+        throw runtime_error("ecdhSharedSecret: peer point is outside the order-q subgroup");
+    }
+
+    ZZ k = priv % q;
+    if (IsZero(k)) throw runtime_error("ecdhSharedSecret: shared point is infinity");
+    long n = NumBits(q) + 1;
+    ZZ k1 = k + q, k2 = k1 + q;
+    const ZZ& lifted = bit(k1, n - 1) ? k1 : k2;
+    vector<char> bits(n);
+    for (long i = 0; i < n; i++) bits[i] = bit(lifted, n - 1 - i);
+    ZZ x;
+    bool ok;
+    switch (fieldBackend) {
+    case FIELD_P256:      ok = fixedWidthLadderX<P256Field>(peer, bits, aECC, x); break;
+    case FIELD_SECP256K1: ok = fixedWidthLadderX<Secp256k1Field>(peer, bits, aECC, x); break;
+    default: {
+        ZZ_p xp;
+        ok = ecCoZLadderX(peer, bits, aECC, xp, ecThreadArena<ZZ_p>());
+        x = rep(xp);
+    }
+    }
+    if (ok) return x;
+
+    // a multiple of the peer's order came up inside the ladder
+    ECPoint S = scalarMultiply(peer, k);
+    if (S.isInfinity) throw runtime_error("ecdhSharedSecret: shared point is infinity");
+    return rep(S.x);
+}
+
+// Online part: C2 = M + yQ from a pooled pair, else the whole encryption inline
+pair<ECPoint, ECPoint> ECElGamalEncryptor::encrypt(const ECPoint& M) const {
+    ZZ_pPush push(crypto->curveContext());
+    if (pool) {
+        unique_ptr<Ephemeral> e = pool->tryTake();
+        if (e) return make_pair(e->first, crypto->pointAdd(e->second, M));
+    }
+    return crypto->elgamalEncryptEC(M, *G, Q);
+}
+
+void ECElGamalEncryptor::startPool(size_t capacity, unsigned workers) {
+    appliedCryptography* c = crypto;
+    shared_ptr<const FixedBaseTable> g = G;
+    ECPoint q = Q;
+    pool = make_shared<PrecomputePool<Ephemeral>>(capacity, [c, g, q] {
+        ZZ_pPush push(c->curveContext());
+        ZZ y = randomNonzero(g->q);
+        return unique_ptr<Ephemeral>(new Ephemeral(c->fixedBaseMultiply(*g, y), c->scalarMultiply(q, y)));
+    }, workers);
+}
+
+void ECElGamalEncryptor::stopPool() {
+    pool.reset();
+}
+
+PoolStats ECElGamalEncryptor::poolStats() const {
+    return pool ? pool->stats() : PoolStats();
+}
+
 
 
 
 // ECDSA=(r,s) using y random in [1,q-1]
 pair<ZZ, ZZ> appliedCryptography::signECDSA(const ZZ& msg, const ZZ& priv, const ECPoint& G, const ZZ& q) {
+    CRYPTO_TIMED();
+    ZZ_pPush push(curveCtx);
     ZZ r, s, y;
+    bool retry = false;
     do {
-        do {
-            y = RandomBnd(q);
-        } while (y == 0);
+        if (retry) CRYPTO_COUNT(CTR_RNG_RETRY);
+        retry = true;
+        y = randomNonzero(q);
 
         ECPoint yP = scalarMultiply(G, y);
         if (yP.isInfinity) continue;
@@ -383,8 +1296,135 @@ pair<ZZ, ZZ> appliedCryptography::signECDSA(const ZZ& msg, const ZZ& priv, const
     return make_pair(r, s);
 }
 
+pair<ZZ, ZZ> appliedCryptography::signECDSA(const ZZ& msg, const ZZ& priv, const FixedBaseTable& G) {
+    CRYPTO_TIMED();
+    ZZ_pPush push(curveCtx);
+    const ZZ& q = G.q;
+    ZZ r, s, y;
+    bool retry = false;
+    do {
+        if (retry) CRYPTO_COUNT(CTR_RNG_RETRY);
+        retry = true;
+        y = randomNonzero(q);
+
+        ECPoint yP = fixedBaseMultiply(G, y);
+        if (yP.isInfinity) continue;
+
+        r = rep(yP.x) % q;
+        if (r == 0) continue;
+
+        ZZ yinv = InvMod(y, q);
+        s = (yinv * (msg + priv * r)) % q;
+    } while (s == 0);
+
+    return make_pair(r, s);
+}
+
+// r = x(yG) mod q and y^-1 mod q for a fresh nonce y, with yG from mult(y)
+template<class Mult>
+static void ecdsaNonce(const ZZ& q, Mult mult, ZZ& r, ZZ& yinv) {
+    ZZ y;
+    for (;;) {
+        y = randomNonzero(q);
+        ECPoint yP = mult(y);
+        if (!yP.isInfinity) {
+            r = rep(yP.x) % q;
+            if (r != 0) break;
+        }
+        CRYPTO_COUNT(CTR_RNG_RETRY);
+    }
+    yinv = InvMod(y, q);
+    zeroize(y);
+}
+
+// The nonce is drawn while the message hashes; a (negligibly likely) s = 0 redraws it
+template<class Mult>
+static pair<ZZ, ZZ> signECDSAHashed(const MessageSource& msg, const ZZ& priv, const ZZ& q, Mult mult) {
+    ZZ r, yinv;
+    ZZ e = hashAlongside(msg, q, [&] { ecdsaNonce(q, mult, r, yinv); });
+    ZZ s = (yinv * (e + priv * r)) % q;
+    while (s == 0) {
+        CRYPTO_COUNT(CTR_RNG_RETRY);
+        ecdsaNonce(q, mult, r, yinv);
+        s = (yinv * (e + priv * r)) % q;
+    }
+    zeroize(yinv);
+    return make_pair(r, s);
+}
+
+pair<ZZ, ZZ> appliedCryptography::signECDSAStream(const MessageSource& msg, const ZZ& priv, const ECPoint& G, const ZZ& q) {
+    ZZ_pPush push(curveCtx);
+    return signECDSAHashed(msg, priv, q, [&](const ZZ& y) { return scalarMultiply(G, y); });
+}
+
+pair<ZZ, ZZ> appliedCryptography::signECDSAStream(const MessageSource& msg, const ZZ& priv, const FixedBaseTable& G) {
+    ZZ_pPush push(curveCtx);
+    return signECDSAHashed(msg, priv, G.q, [&](const ZZ& y) { return fixedBaseMultiply(G, y); });
+}
+
+ECDSAPresignature::~ECDSAPresignature() {
+    zeroize(yinv);
+    zeroize(r);
+}
+
+ECDSAPresigner::ECDSAPresigner(appliedCryptography& crypto, const FixedBaseTable& G, size_t capacity, unsigned workers)
+    : crypto(&crypto), G(make_shared<const FixedBaseTable>(G)),
+      pool(capacity, [c = &crypto, g = this->G] {
+          ZZ_pPush push(c->curveContext());
+          unique_ptr<ECDSAPresignature> pre(new ECDSAPresignature);
+          ZZ y;
+          bool retry = false;
+          do {
+              if (retry) CRYPTO_COUNT(CTR_RNG_RETRY);
+              retry = true;
+              y = randomNonzero(g->q);
+              ECPoint yP = c->fixedBaseMultiply(*g, y);
+              if (yP.isInfinity) continue;
+              pre->r = rep(yP.x) % g->q;
+          } while (pre->r == 0);
+          pre->yinv = InvMod(y, g->q);
+          zeroize(y);
+          return pre;
+      }, workers) {}
+
+// s = y^-1 (msg + priv * r) mod q from one presignature, which is wiped when it goes out of scope
+// Everything derived from priv or y^-1 stays in named registers, wiped on the way out
+bool ECDSAPresigner::trySign(const ZZ& msg, const ZZ& priv, pair<ZZ,ZZ>& sig) {
+    const ZZ& q = G->q;
+    ZZ e, k, t, s;
+    rem(e, msg, q);
+    rem(k, priv, q);
+    bool ok = false;
+    for (;;) {
+        unique_ptr<ECDSAPresignature> pre = pool.tryTake();
+        if (!pre) break;
+        MulMod(t, k, pre->r, q);
+        AddMod(t, t, e, q);             // msg + priv * r
+        MulMod(s, pre->yinv, t, q);
+        if (IsZero(s)) {
+            CRYPTO_COUNT(CTR_RNG_RETRY);
+            continue;
+        }
+        sig = make_pair(pre->r, s);
+        ok = true;
+        break;
+    }
+    zeroize(k);
+    zeroize(t);
+    zeroize(s);
+    return ok;
+}
+
+pair<ZZ,ZZ> ECDSAPresigner::sign(const ZZ& msg, const ZZ& priv) {
+    pair<ZZ,ZZ> sig;
+    if (trySign(msg, priv, sig)) return sig;
+    return crypto->signECDSA(msg, priv, *G);
+}
+
 // Verify signature
 bool appliedCryptography::verifyECDSA(const ZZ& msg, const pair<ZZ, ZZ>& sig, const ECPoint& G, const ECPoint& Q, const ZZ& q) {
+    CRYPTO_TIMED();
+    ZZ_pPush push(curveCtx);
     ZZ r = sig.first, s = sig.second;
     if (r <= 0 || r >= q || s <= 0 || s >= q) return false;
 
@@ -392,13 +1432,204 @@ bool appliedCryptography::verifyECDSA(const ZZ& msg, const pair<ZZ, ZZ>& sig, co
     ZZ i = (msg * w) % q;
     ZZ j = (r * w) % q;
 
-    ECPoint iP = scalarMultiply(G, i);
-    ECPoint jQ = scalarMultiply(Q, j);
-    ECPoint R = pointAdd(iP, jQ);
+    ECPoint R = toAffine(cachedMultiScalarMultiplyJ(G, i, Q, j));    // iG + jQ, one doubling chain or two combs
 
     if (R.isInfinity) return false;
     ZZ x0 = rep(R.x) % q;
     return (x0 == r);
 }
 
- 
\ No newline at end of file
+ 
+
+// Small inputs take verifyECDSA's joint iG + jQ chain after hashing. Large ones compute jQ while the
+// message hashes and add iG afterwards: two chains instead of one, but the second is hidden.
+bool appliedCryptography::verifyECDSAStream(const MessageSource& msg, const pair<ZZ, ZZ>& sig, const ECPoint& G, const ECPoint& Q, const ZZ& q) {
+    ZZ_pPush push(curveCtx);
+    const ZZ& r = sig.first;
+    const ZZ& s = sig.second;
+    if (r <= 0 || r >= q || s <= 0 || s >= q) return false;     // before reading the message
+    if (!overlapHashing(msg)) return verifyECDSA(hashToScalar(msg, q), sig, G, Q, q);
+
+    ZZ w;
+    ECPointJ jQ;
+    ZZ e = hashAlongside(msg, q, [&] {
+        w = InvMod(s, q);
+        jQ = cachedScalarMultiplyJ(Q, (r * w) % q);
+    });
+    ECPoint R = toAffine(jacobianAdd(cachedScalarMultiplyJ(G, (e * w) % q), jQ));
+    if (R.isInfinity) return false;
+    return rep(R.x) % q == r;
+}
+
+// Batch verify: Montgomery's trick for the s inverses mod q and for the final affine conversion
+vector<bool> appliedCryptography::verifyECDSABatch(const ECDSAVerifyItem* items, size_t n, const ECPoint& G, const ZZ& q) {
+    CRYPTO_TIMED();
+    ZZ_pPush push(curveCtx);
+    vector<bool> ok(n, false);
+
+    // items that pass the range check
+    vector<size_t> idx;
+    idx.reserve(n);
+    for (size_t k = 0; k < n; k++) {
+        const ZZ& r = items[k].sig.first;
+        const ZZ& s = items[k].sig.second;
+        if (r <= 0 || r >= q || s <= 0 || s >= q) continue;
+        idx.push_back(k);
+    }
+    size_t m = idx.size();
+    if (m == 0) return ok;
+
+    // w_k = s_k^-1 mod q for all k with a single InvMod
+    vector<ZZ> prefix(m);
+    ZZ acc(1);
+    for (size_t t = 0; t < m; t++) {
+        prefix[t] = acc;
+        MulMod(acc, acc, items[idx[t]].sig.second, q);
+    }
+    ZZ accInv = InvMod(acc, q);
+    vector<ZZ> w(m);
+    for (size_t t = m; t-- > 0; ) {
+        const ZZ& s = items[idx[t]].sig.second;
+        MulMod(w[t], accInv, prefix[t], q);
+        MulMod(accInv, accInv, s, q);
+    }
+
+    // R_k = i_k G + j_k Q_k, left in Jacobian
+    vector<ECPointJ> R(m);
+    for (size_t t = 0; t < m; t++) {
+        const ECDSAVerifyItem& it = items[idx[t]];
+        ZZ i = (it.msg * w[t]) % q;
+        ZZ j = (it.sig.first * w[t]) % q;
+        R[t] = cachedMultiScalarMultiplyJ(G, i, it.Q, j);
+    }
+
+    vector<ECPoint> A = normalizeBatch(R);
+    for (size_t t = 0; t < m; t++) {
+        if (A[t].isInfinity) continue;
+        ok[idx[t]] = (rep(A[t].x) % q == items[idx[t]].sig.first);
+    }
+    return ok;
+}
+
+vector<bool> appliedCryptography::verifyECDSABatch(const vector<ECDSAVerifyItem>& items, const ECPoint& G, const ZZ& q) {
+    return verifyECDSABatch(items.data(), items.size(), G, q);
+}
+
+
+// Parallel batch APIs: each worker installs the curve modulus for its whole shard
+vector<pair<ZZ, ZZ>> appliedCryptography::signECDSAParallel(const vector<ZZ>& msgs, const ZZ& priv, const ECPoint& G, const ZZ& q, unsigned threads) {
+    vector<pair<ZZ, ZZ>> sigs(msgs.size());
+    parallelFor(msgs.size(), threads, [&](size_t begin, size_t end) {
+        ZZ_pPush push(curveCtx);
+        for (size_t i = begin; i < end; i++) sigs[i] = signECDSA(msgs[i], priv, G, q);
+    });
+    return sigs;
+}
+
+vector<pair<ZZ, ZZ>> appliedCryptography::signECDSAParallel(const vector<ZZ>& msgs, const ZZ& priv, const FixedBaseTable& G, unsigned threads) {
+    vector<pair<ZZ, ZZ>> sigs(msgs.size());
+    parallelFor(msgs.size(), threads, [&](size_t begin, size_t end) {
+        ZZ_pPush push(curveCtx);
+        for (size_t i = begin; i < end; i++) sigs[i] = signECDSA(msgs[i], priv, G);
+    });
+    return sigs;
+}
+
+vector<bool> appliedCryptography::verifyECDSAParallel(const vector<ECDSAVerifyItem>& items, const ECPoint& G, const ZZ& q, unsigned threads) {
+    vector<char> ok(items.size(), 0);      // vector<bool> is not safe to write from several threads
+    parallelFor(items.size(), threads, [&](size_t begin, size_t end) {
+        ZZ_pPush push(curveCtx);
+        vector<bool> part = verifyECDSABatch(items.data() + begin, end - begin, G, q);
+        for (size_t i = begin; i < end; i++) ok[i] = part[i - begin];
+    });
+    return vector<bool>(ok.begin(), ok.end());
+}
+
+vector<pair<ECPoint, ECPoint>> appliedCryptography::elgamalEncryptECParallel(const vector<ECPoint>& msgs, const ECPoint& G, const ECPoint& Q, const ZZ& q, unsigned threads) {
+    ZZ_pPush push(curveCtx);
+    vector<pair<ECPoint, ECPoint>> out(msgs.size());
+    parallelFor(msgs.size(), threads, [&](size_t begin, size_t end) {
+        ZZ_pPush push(curveCtx);
+        for (size_t i = begin; i < end; i++) out[i] = elgamalEncryptEC(msgs[i], G, Q, q);
+    });
+    return out;
+}
+
+
+// Wire format: fixed-width SEC1 points
+void appliedCryptography::encodePoint(const ECPoint& P, unsigned char* out, bool compressed) {
+    long L = fieldBytes();
+    if (P.isInfinity) {
+        fill(out, out + pointBytes(compressed), 0);
+        return;
+    }
+    ZZ_pPush push(curveCtx);
+    if (compressed) {
+        out[0] = bit(rep(P.y), 0) ? 0x03 : 0x02;
+        encodeScalar(rep(P.x), out + 1, L);
+    } else {
+        out[0] = 0x04;
+        encodeScalar(rep(P.x), out + 1, L);
+        encodeScalar(rep(P.y), out + 1 + L, L);
+    }
+}
+
+ECPoint appliedCryptography::decodePoint(const unsigned char* in, bool compressed) {
+    long L = fieldBytes();
+    long n = pointBytes(compressed);
+    if (in[0] == 0x00) {
+        for (long i = 1; i < n; i++) {
+            if (in[i]) throw runtime_error("decodePoint: malformed point at infinity");
+        }
+        return ECPoint();
+    }
+    if (compressed ? (in[0] != 0x02 && in[0] != 0x03) : in[0] != 0x04) throw runtime_error("decodePoint: bad prefix");
+
+    ZZ_pPush push(curveCtx);
+    ZZ x = decodeScalar(in + 1, L);
+    if (x >= pECC) throw runtime_error("decodePoint: x out of range");
+    ZZ_p X = conv<ZZ_p>(x);
+    ZZ_p rhs = (sqr(X) + aECC) * X + bECC;       // x^3 + a x + b
+    ZZ_p Y;
+    if (compressed) {
+        const ExpRecoding* e = curveSqrt.threeModFourExponent();
+        bool found;
+        if (e && fieldBackend == FIELD_P256) found = fixedWidthSqrt<P256Field>(Y, rhs, *e);
+        else if (e && fieldBackend == FIELD_SECP256K1) found = fixedWidthSqrt<Secp256k1Field>(Y, rhs, *e);
+        else found = curveSqrt(Y, rhs);
+        if (!found) throw runtime_error("decodePoint: x is not on the curve");
+        if (bit(rep(Y), 0) != (in[0] & 1)) {
+            if (IsZero(Y)) throw runtime_error("decodePoint: bad parity for y = 0");
+            Y = -Y;
+        }
+    } else {
+        ZZ y = decodeScalar(in + 1 + L, L);
+        if (y >= pECC) throw runtime_error("decodePoint: y out of range");
+        Y = conv<ZZ_p>(y);
+        if (sqr(Y) != rhs) throw runtime_error("decodePoint: point is not on the curve");
+    }
+    return ECPoint(X, Y);
+}
+
+void appliedCryptography::encodePoints(const ECPoint* pts, size_t n, unsigned char* out, bool compressed) {
+    ZZ_pPush push(curveCtx);
+    long step = pointBytes(compressed);
+    for (size_t i = 0; i < n; i++) encodePoint(pts[i], out + i * step, compressed);
+}
+
+void appliedCryptography::decodePoints(const unsigned char* in, size_t n, ECPoint* out, bool compressed) {
+    ZZ_pPush push(curveCtx);
+    long step = pointBytes(compressed);
+    for (size_t i = 0; i < n; i++) out[i] = decodePoint(in + i * step, compressed);
+}
+
+void appliedCryptography::encodeCiphertext(const pair<ECPoint, ECPoint>& C, unsigned char* out, bool compressed) {
+    encodePoint(C.first, out, compressed);
+    encodePoint(C.second, out + pointBytes(compressed), compressed);
+}
+
+pair<ECPoint, ECPoint> appliedCryptography::decodeCiphertext(const unsigned char* in, bool compressed) {
+    ZZ_pPush push(curveCtx);
+    ECPoint C1 = decodePoint(in, compressed);
+    return make_pair(C1, decodePoint(in + pointBytes(compressed), compressed));
+}
@@ -1,76 +1,349 @@
+#pragma once
 #include <string>
+#include <vector>
 #include <NTL/mat_ZZ.h>
 #include <NTL/mat_ZZ_p.h>
+#include "ecjacobian.hpp"
+#include "classical.hpp"
+#include "hill.hpp"
+#include "modexp.hpp"
+#include "elgamal.hpp"
+#include "precompute.hpp"
+#include "wire.hpp"
+#include "sha256.hpp"
 using namespace std;
 using namespace NTL;
 
 
-struct ECPoint {
-    ZZ_p x, y;
-    bool isInfinity;
-    ECPoint() : isInfinity(true) {}
-    ECPoint(ZZ_p _x, ZZ_p _y) : x(_x), y(_y), isInfinity(false) {}
+typedef AffinePoint<ZZ_p> ECPoint;
+typedef JacobianPoint<ZZ_p> ECPointJ;
+
+
+// Field arithmetic used by the EC point code; initCurve picks a fixed-width backend when p matches
+enum FieldBackend { FIELD_GENERIC, FIELD_P256, FIELD_SECP256K1 };
+
+
+// Fixed-base table for a generator G of order q: rows[i][j-1] = j * 2^(w*i) * G
+// k*G is then one table lookup and one mixed addition per w-bit window, no doublings
+struct FixedBaseTable {
+    ECPoint G;
+    ZZ q;
+    long w = 0;
+    vector<vector<ECPoint>> rows;
 };
 
 
+// Comb table for one cached public key, kept in the field backend it was built for (assign.cpp)
+struct KeyTable;
+
+
+// One ECDSA verification job for verifyECDSABatch
+struct ECDSAVerifyItem {
+    ZZ msg;
+    pair<ZZ,ZZ> sig;
+    ECPoint Q;
+};
+
+
+// One ElGamal signature (gamma, delta) on m for elGamalVerifyBatch, h = g^x the signer's key
+struct ElGamalSigItem {
+    ZZ m;
+    ZZ gamma, delta;
+    ZZ h;
+};
+
+
+// Width-w NAF digits of k, least significant first; nonzero digits are odd and |d| < 2^(w-1)
+vector<long> wnafDigits(const ZZ& k, long w);
+// Same into an existing vector, reusing its capacity
+void wnafDigits(vector<long>& digits, const ZZ& k, long w);
+
+
+// Each instance owns its curve modulus (curveCtx) and installs it for the duration of every EC call,
+// so instances on different curves and the caller's own ZZ_p modulus don't interfere.
+// With a thread-safe NTL build (NTL_THREADS, the default) one instance can be shared by several threads.
 class appliedCryptography {
 
 private:
+    ZZ_pContext curveCtx;                     // modulus p of the curve set by initCurve
     ZZ pECC;      // Field modulus
     ZZ_p aECC;    // Curve coefficient a
     ZZ_p bECC;    // Curve coefficient b
+    long wnafWidth = 5;   // window width used by scalarMultiply
+    FieldBackend fieldBackend = FIELD_GENERIC;
+    bool fixedWidthEnabled = true;
+    ModSqrt curveSqrt;    // square roots mod p for point decompression
+    shared_ptr<TableCache<KeyTable>> keyCache;   // null while the key cache is off
+    long keyCacheWidth = 4;
+
+    // GLV endomorphism phi(x, y) = (beta x, y) = lambda (x, y) of an a = 0 curve of prime order n
+    struct GLVParams {
+        ZZ n;
+        ZZ_p beta;
+        ZZ lambda;
+        ZZ a1, b1, a2, b2;      // short basis of {(u, v) : u + v lambda = 0 mod n}
+        ZZ g1, g2;              // round(2^shift |b2| / n), round(2^shift |b1| / n)
+        bool neg1 = false, neg2 = false;    // signs of b2 and -b1
+        long shift = 0;
+    } glv;
+    bool glvAvailable = false;
+    bool glvEnabled = true;
+    ZZ orderECC;                    // order of the key group given to initCurve, 0 when unknown
+    bool primeOrderCurve = false;   // the key group is the whole curve
+
+    void selectFieldBackend();
+    void setCurveOrder(const ZZ& n);
+    ECPoint curvePoint();           // some point of the curve, x = 1, 2, ...
+    void setupGLV(const ZZ& n);
+    // k = k1 + k2 lambda (mod n) with k1, k2 about sqrt(n), as wNAF digit strings
+    void glvSplit(vector<long>& naf1, vector<long>& naf2, const ZZ& k) const;
+    // sum ks[i] * pts[i], every scalar split in two and all 2n digit strings in one doubling chain
+    ECPointJ glvMultiplyJ(const ECPoint* pts, const ZZ* ks, size_t n);
+    // Cached comb for P under the current backend, null until P has been used buildAfter times
+    shared_ptr<const KeyTable> keyTable(const ECPoint& P);
+    // k*P and a*P + b*Q through the key cache, falling back to the wNAF paths
+    ECPointJ cachedScalarMultiplyJ(const ECPoint& P, const ZZ& k);
+    ECPointJ cachedMultiScalarMultiplyJ(const ECPoint& P, const ZZ& a, const ECPoint& Q, const ZZ& b);
 
 public:
+    // Curve modulus, for code that builds ZZ_p values on its own threads
+    const ZZ_pContext& curveContext() const { return curveCtx; }
+
     // Shift Cipher
-    string shiftEncrypt(string text, int key);
-    string shiftDecrypt(string text, int key);
+    string shiftEncrypt(const string& text, int key);
+    string shiftDecrypt(const string& text, int key);
 
 
     // Vigenere Cipher
-    string vigenereEncrypt(string text, string key);
-    string vigenereDecrypt(string text, string key);
+    string vigenereEncrypt(const string& text, const string& key);
+    string vigenereDecrypt(const string& text, const string& key);
+    // Precompiled key: build VigenereKey once and reuse it across messages
+    string vigenereEncrypt(const string& text, const VigenereKey& key);
+    string vigenereDecrypt(const string& text, const VigenereKey& key);
 
 
     // Hill Cipher 
     string hillEncrypt(string text, mat_ZZ_p key);
     string hillDecrypt(const string& ciphertext, const mat_ZZ_p& key);
+    // Precompiled key: build HillKey once and reuse it across messages
+    string hillEncrypt(const string& text, const HillKey& key);
+    string hillDecrypt(const string& ciphertext, const HillKey& key);
 
     
     //OTP
     string generateRandomKey(int length);
-    string otpEncrypt(string plaintext, string key);
-    string otpDecrypt(string ciphertext, string key);
+    string otpEncrypt(const string& plaintext, const string& key);
+    string otpDecrypt(const string& ciphertext, const string& key);
+    // Buffer versions, no copies: out may be the same buffer as in; keyLen must be >= n
+    void otpXor(unsigned char* out, const unsigned char* in, size_t n, const unsigned char* key, size_t keyLen);
+    void otpXorInPlace(unsigned char* data, size_t n, const unsigned char* key, size_t keyLen);
 
 
   
     //Diffie Helman key exchange protocol
     ZZ_p diffiePublicKeyNTL(ZZ_p privateKey, ZZ_p g);
     ZZ_p diffieSharedKeyNTL(ZZ_p receivedKey, ZZ_p privateKey);
+    // Full-size ZZ private keys (sliding-window modexp in the current modulus)
+    ZZ_p diffiePublicKeyNTL(const ZZ& privateKey, const ZZ_p& g);
+    ZZ_p diffieSharedKeyNTL(const ZZ_p& receivedKey, const ZZ& privateKey);
+    // Fixed-base table for g, build once per group and reuse for every public key
+    ModExpTable precomputeDiffieBase(const ZZ_p& g, long maxBits = 0, long w = 4);
+    ZZ_p diffiePublicKeyNTL(const ZZ& privateKey, const ModExpTable& g);
+    // received[i]^privateKey for all i, sharded over `threads` workers (0 = one per hardware thread)
+    vector<ZZ_p> diffieSharedKeysParallel(const vector<ZZ_p>& received, const ZZ& privateKey, unsigned threads = 0);
 
     
     // ElGamal Encryption / Decryption
     ZZ_p generateRandomY();
     void elGamalEncrypt(const ZZ_p& g, const ZZ_p& h, const ZZ_p& m, ZZ_p& c1, ZZ_p& c2);
+    // Precomputed recipient: build ElGamalEncryptor(g, h) once and reuse it across messages
+    void elGamalEncrypt(const ElGamalEncryptor& enc, const ZZ_p& m, ZZ_p& c1, ZZ_p& c2);
     ZZ_p elGamalDecrypt(const ZZ_p& x, const ZZ_p& c1, const ZZ_p& c2);
    
 
     // ElGamal Digital Signature
     void elGamalSign(const ZZ& p, const ZZ& g, const ZZ& x, const ZZ& m, ZZ& gamma, ZZ& delta);
     bool elGamalVerify(const ZZ& p, const ZZ& g, const ZZ& h, const ZZ& m, const ZZ& gamma, const ZZ& delta);
+    // Per-item results equal to elGamalVerify. For a safe prime p = 2q + 1 (q prime, above 2^64) it is
+    // one multi-exponentiation for the whole batch, bisected only when it fails, with a forged item
+    // accepted with probability below 2^-63; any other p is checked item by item.
+    vector<bool> elGamalVerifyBatch(const ZZ& p, const ZZ& g, const vector<ElGamalSigItem>& items);
+    // Hash-then-sign over a streamed message, m = hashToScalar(msg, p - 1); see signECDSAStream
+    void elGamalSignStream(const ZZ& p, const ZZ& g, const ZZ& x, const MessageSource& msg, ZZ& gamma, ZZ& delta);
+    bool elGamalVerifyStream(const ZZ& p, const ZZ& g, const ZZ& h, const MessageSource& msg, const ZZ& gamma, const ZZ& delta);
 
 
     void initCurve(const ZZ& _pECC, const ZZ_p& _aECC, const ZZ_p& _bECC);
+    // Same with the order n of the group keys live in: the whole curve, or a subgroup when the
+    // cofactor is above 1 (ecdhSharedSecret needs it). On a = 0 curves with p = 1 mod 3 and prime
+    // order n (cofactor 1), initCurve finds the endomorphism (x, y) -> (beta x, y) = lambda (x, y), and
+    // scalarMultiply, multiScalarMultiply and ECDSA verification split each scalar into two of half
+    // the length (GLV), halving the doublings. The 3-argument form does both for secp256k1 by itself.
+    void initCurve(const ZZ& _pECC, const ZZ_p& _aECC, const ZZ_p& _bECC, const ZZ& order);
     ECPoint pointAdd(const ECPoint& P, const ECPoint& Q);
     ECPoint pointDouble(const ECPoint& P);
     ECPoint pointNeg(const ECPoint& P);
     ECPoint scalarMultiply(const ECPoint& P, const ZZ& k);
 
+    // In place: results go into caller-owned points whose coordinates keep their limbs, and
+    // temporaries come from a per-thread arena, so once warmed up these never touch the heap.
+    // out may alias an input.
+    void pointAddInto(ECPoint& out, const ECPoint& P, const ECPoint& Q);
+    void pointDoubleInto(ECPoint& out, const ECPoint& P);
+    void scalarMultiplyInto(ECPoint& out, const ECPoint& P, const ZZ& k);
+
+    // Inversion-free Jacobian arithmetic, normalize with toAffine once at the end
+    ECPointJ toJacobian(const ECPoint& P);
+    ECPoint toAffine(const ECPointJ& P);
+    ECPointJ jacobianDouble(const ECPointJ& P);
+    ECPointJ jacobianAdd(const ECPointJ& P, const ECPointJ& Q);
+    ECPointJ jacobianAddMixed(const ECPointJ& P, const ECPoint& Q);
+    ECPointJ scalarMultiplyJ(const ECPoint& P, const ZZ& k);
+    vector<ECPoint> normalizeBatch(const vector<ECPointJ>& pts);
+
+    // Width-w NAF scalar multiplication (w in [2, 8], default 5)
+    void setWindowWidth(long w);
+    long windowWidth() const { return wnafWidth; }
+    vector<ECPoint> oddMultiples(const ECPoint& P, long w);
+
+    // Fixed-width Montgomery field for P-256 / secp256k1 moduli (on by default, ZZ_p otherwise)
+    void useFixedWidthField(bool enable);
+    FieldBackend fieldBackendInUse() const { return fieldBackend; }
+
+    // GLV scalar splitting when initCurve found the endomorphism (on by default)
+    void useGLV(bool enable) { glvEnabled = enable; }
+    bool glvInUse() const { return glvAvailable && glvEnabled; }
+
+    // a*P + b*Q in one doubling chain (interleaved wNAF, Straus/Shamir)
+    ECPointJ multiScalarMultiplyJ(const ECPoint& P, const ZZ& a, const ECPoint& Q, const ZZ& b);
+    ECPoint multiScalarMultiply(const ECPoint& P, const ZZ& a, const ECPoint& Q, const ZZ& b);
+
+    // Fixed-base comb for a generator, build once per curve/generator and reuse
+    FixedBaseTable precomputeFixedBase(const ECPoint& G, const ZZ& q, long w = 4);
+    ECPointJ fixedBaseMultiplyJ(const FixedBaseTable& T, const ZZ& k);
+    ECPoint fixedBaseMultiply(const FixedBaseTable& T, const ZZ& k);
+
+    bool isOnCurve(const ECPoint& P);
+
     void keyGen(const ECPoint& G, const ZZ& q, ZZ& priv, ECPoint& Q);
+    void keyGen(const FixedBaseTable& G, ZZ& priv, ECPoint& Q);
     pair<ECPoint, ECPoint> elgamalEncryptEC(const ECPoint& M, const ECPoint& G, const ECPoint& Q, const ZZ& q);
+    pair<ECPoint, ECPoint> elgamalEncryptEC(const ECPoint& M, const FixedBaseTable& G, const ECPoint& Q);
     ECPoint elgamalDecryptEC(const pair<ECPoint, ECPoint>& C, const ZZ& priv);
 
+    // ECDH: x(priv * peer) through the co-Z Montgomery ladder, in the order-q group given to initCurve
+    // (set by itself for secp256k1). On a prime-order curve every point on it is accepted; otherwise
+    // the peer must also satisfy q * peer = O, which costs one more scalar multiplication. The key is
+    // run as priv mod q plus q or 2q, so the ladder always takes NumBits(q) steps whatever the key's
+    // length, and picks registers by a conditional swap instead of indexing with key bits. That swap
+    // is masked and branch-free on the fixed-width fields only; on ZZ_p it is a branch, and ZZ_p
+    // arithmetic is variable-time anyway. Keys within a few of 0 or q (and many keys in tiny groups)
+    // hit a multiple of q inside the ladder and fall back to the variable-time wNAF scalarMultiply.
+    // The ladder does 9M + 5S per bit against about 5M + 6S for wNAF, so it does not beat
+    // scalarMultiply: roughly 0.85x on fixed-width P-256, 0.9x on ZZ_p (bench ecdh reports it), and
+    // well behind the GLV path on secp256k1. Throws runtime_error if the order is unknown, priv <= 0,
+    // the peer is infinity, off the curve or outside the subgroup, or the result is infinity.
+    ZZ ecdhSharedSecret(const ZZ& priv, const ECPoint& peer);
+
+
+    // Public-key table cache, off by default. verifyECDSA, verifyECDSAStream, verifyECDSABatch and
+    // elgamalEncryptEC look their points up (G included), and from a point's buildAfter-th use on run
+    // k*P as a fixed-base comb of w-bit windows: one mixed addition per window, no doublings. At most
+    // `capacity` points are tracked, least recently used dropped first; a table holds about
+    // log2(p) / w * (2^w - 1) affine points. initCurve and useFixedWidthField start it empty.
+    // Copies of this object share the cache.
+    void enableKeyCache(size_t capacity, uint64_t buildAfter = 2, long w = 4);
+    void disableKeyCache();
+    CacheStats keyCacheStats() const;
+
 
     pair<ZZ,ZZ> signECDSA(const ZZ& msg, const ZZ& priv, const ECPoint& G, const ZZ& q);
+    pair<ZZ,ZZ> signECDSA(const ZZ& msg, const ZZ& priv, const FixedBaseTable& G);
     bool verifyECDSA(const ZZ& msg, const pair<ZZ,ZZ>& sig, const ECPoint& G, const ECPoint& Q, const ZZ& q);
+    // Per-item results; one InvMod for all s^-1 and one field inversion for all result points
+    vector<bool> verifyECDSABatch(const ECDSAVerifyItem* items, size_t n, const ECPoint& G, const ZZ& q);
+    vector<bool> verifyECDSABatch(const vector<ECDSAVerifyItem>& items, const ECPoint& G, const ZZ& q);
+    // Hash-then-sign over a streamed message: msg = hashToScalar(source, q), so the signatures are the
+    // ones signECDSA / verifyECDSA give for that scalar. Inputs of 64 KiB or more (or of unknown size)
+    // are hashed on a helper thread while the message-independent part runs on the caller's: the nonce
+    // point when signing, s^-1 and (r/s) * Q when verifying.
+    pair<ZZ,ZZ> signECDSAStream(const MessageSource& msg, const ZZ& priv, const ECPoint& G, const ZZ& q);
+    pair<ZZ,ZZ> signECDSAStream(const MessageSource& msg, const ZZ& priv, const FixedBaseTable& G);
+    bool verifyECDSAStream(const MessageSource& msg, const pair<ZZ,ZZ>& sig, const ECPoint& G, const ECPoint& Q, const ZZ& q);
+
+
+    // Thread-parallel batch jobs, sharded over `threads` workers (0 = one per hardware thread)
+    vector<pair<ZZ,ZZ>> signECDSAParallel(const vector<ZZ>& msgs, const ZZ& priv, const ECPoint& G, const ZZ& q, unsigned threads = 0);
+    vector<pair<ZZ,ZZ>> signECDSAParallel(const vector<ZZ>& msgs, const ZZ& priv, const FixedBaseTable& G, unsigned threads = 0);
+    vector<bool> verifyECDSAParallel(const vector<ECDSAVerifyItem>& items, const ECPoint& G, const ZZ& q, unsigned threads = 0);
+    vector<pair<ECPoint, ECPoint>> elgamalEncryptECParallel(const vector<ECPoint>& msgs, const ECPoint& G, const ECPoint& Q, const ZZ& q, unsigned threads = 0);
+
+
+    // SEC1 wire format in the curve field, each coordinate fieldBytes() big-endian:
+    // 02/03 || x compressed (low bit of y), 04 || x || y uncompressed. Infinity is 00 zero-padded
+    // to the same fixed width. Decoding throws runtime_error on bad prefixes, coordinates >= p
+    // and points not on the curve.
+    long fieldBytes() const { return NumBytes(pECC); }
+    long pointBytes(bool compressed = true) const { return compressed ? 1 + fieldBytes() : 1 + 2 * fieldBytes(); }
+    void encodePoint(const ECPoint& P, unsigned char* out, bool compressed = true);
+    ECPoint decodePoint(const unsigned char* in, bool compressed = true);
+    // n points back to back, pointBytes(compressed) each
+    void encodePoints(const ECPoint* pts, size_t n, unsigned char* out, bool compressed = true);
+    void decodePoints(const unsigned char* in, size_t n, ECPoint* out, bool compressed = true);
+    // EC-ElGamal ciphertext as C1 || C2
+    void encodeCiphertext(const pair<ECPoint, ECPoint>& C, unsigned char* out, bool compressed = true);
+    pair<ECPoint, ECPoint> decodeCiphertext(const unsigned char* in, bool compressed = true);
+
+};
+
+
+// EC-ElGamal to one recipient Q. startPool keeps up to `capacity` message-independent pairs (yG, yQ)
+// ready on background threads, so encrypt is one point addition when the pool has an entry and
+// falls back to elgamalEncryptEC otherwise. `crypto` must outlive the encryptor and keep its curve.
+// Copies share the pool.
+class ECElGamalEncryptor {
+public:
+    ECElGamalEncryptor(appliedCryptography& crypto, const FixedBaseTable& G, const ECPoint& Q);
+
+    pair<ECPoint, ECPoint> encrypt(const ECPoint& M) const;
+
+    void startPool(size_t capacity, unsigned workers = 1);
+    void stopPool();
+    PoolStats poolStats() const;
 
+private:
+    typedef pair<ECPoint, ECPoint> Ephemeral;    // (yG, yQ)
+
+    appliedCryptography* crypto;
+    shared_ptr<const FixedBaseTable> G;
+    ECPoint Q;
+    shared_ptr<PrecomputePool<Ephemeral>> pool;
+};
+
+
+// One ECDSA presignature: y^-1 mod q and r = x(yG) mod q for a fresh nonce y. Wiped on destruction.
+struct ECDSAPresignature {
+    ZZ yinv;
+    ZZ r;
+    ~ECDSAPresignature();
+};
+
+// ECDSA signing from presignatures computed ahead of time on background threads (up to `capacity`
+// of them; workers stop producing while the pool is full). Each presignature is handed out once and
+// wiped right after use, so signing is two multiplications mod q. sign falls back to signECDSA when
+// the pool is empty; trySign reports it instead so the caller can back off. `crypto` must outlive the
+// presigner and keep its curve.
+class ECDSAPresigner {
+public:
+    ECDSAPresigner(appliedCryptography& crypto, const FixedBaseTable& G, size_t capacity = 256, unsigned workers = 1);
+
+    pair<ZZ,ZZ> sign(const ZZ& msg, const ZZ& priv);
+    bool trySign(const ZZ& msg, const ZZ& priv, pair<ZZ,ZZ>& sig);
+
+    PoolStats stats() const { return pool.stats(); }
+
+private:
+    appliedCryptography* crypto;
+    shared_ptr<const FixedBaseTable> G;
+    PrecomputePool<ECDSAPresignature> pool;
 };
@@ -0,0 +1,210 @@
+#include "classical.hpp"
+#include <cctype>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LETTERS_X86 1
+#endif
+
+static inline unsigned char rotateLetter(unsigned char c, unsigned r) {
+    if (c >= 'A' && c <= 'Z') return (unsigned char)('A' + (c - 'A' + r) % 26);
+    if (c >= 'a' && c <= 'z') return (unsigned char)('a' + (c - 'a' + r) % 26);
+    return c;
+}
+
+static inline bool isLetter(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+static void rotateScalar(unsigned char* out, const unsigned char* in, size_t n, unsigned r) {
+    for (size_t i = 0; i < n; i++) out[i] = rotateLetter(in[i], r);
+}
+
+static size_t rotateKeyedScalar(unsigned char* out, const unsigned char* in, size_t n,
+                                const unsigned char* stream, size_t period, size_t j) {
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = in[i];
+        if (isLetter(c)) {
+            out[i] = rotateLetter(c, stream[j]);
+            if (++j == period) j = 0;
+        } else {
+            out[i] = c;
+        }
+    }
+    return j;
+}
+
+#ifdef LETTERS_X86
+// Byte masks of the upper- and lower-case letters in c
+__attribute__((target("ssse3")))
+static inline __m128i letters16(__m128i c, __m128i& lower) {
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('Z' + 1)));
+    lower = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('z' + 1)));
+    return _mm_or_si128(upper, lower);
+}
+
+// 16 bytes with each letter rotated by the matching byte of rv; `letter` gets the letter mask
+__attribute__((target("ssse3")))
+static inline __m128i rotate16(__m128i c, __m128i rv, __m128i& letter) {
+    __m128i lower;
+    letter = letters16(c, lower);
+
+    __m128i base = _mm_add_epi8(_mm_set1_epi8('A'), _mm_and_si128(lower, _mm_set1_epi8(0x20)));
+    __m128i x = _mm_add_epi8(_mm_sub_epi8(c, base), rv);                  // 0..50 for letters
+    x = _mm_sub_epi8(x, _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(25)), _mm_set1_epi8(26)));
+    __m128i res = _mm_add_epi8(x, base);
+    return _mm_or_si128(_mm_and_si128(letter, res), _mm_andnot_si128(letter, c));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i rotate32(__m256i c, __m256i rv, __m256i& letter) {
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), c));
+    __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), c));
+    letter = _mm256_or_si256(upper, lower);
+
+    __m256i base = _mm256_add_epi8(_mm256_set1_epi8('A'), _mm256_and_si256(lower, _mm256_set1_epi8(0x20)));
+    __m256i x = _mm256_add_epi8(_mm256_sub_epi8(c, base), rv);
+    x = _mm256_sub_epi8(x, _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8(25)), _mm256_set1_epi8(26)));
+    __m256i res = _mm256_add_epi8(x, base);
+    return _mm256_blendv_epi8(c, res, letter);
+}
+
+__attribute__((target("ssse3")))
+static void rotateSSSE3(unsigned char* out, const unsigned char* in, size_t n, unsigned r) {
+    __m128i rv = _mm_set1_epi8((char)r);
+    __m128i letter;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(in + i));
+        _mm_storeu_si128((__m128i*)(out + i), rotate16(c, rv, letter));
+    }
+    rotateScalar(out + i, in + i, n - i, r);
+}
+
+__attribute__((target("avx2")))
+static void rotateAVX2(unsigned char* out, const unsigned char* in, size_t n, unsigned r) {
+    __m256i rv = _mm256_set1_epi8((char)r);
+    __m256i letter;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i c = _mm256_loadu_si256((const __m256i*)(in + i));
+        _mm256_storeu_si256((__m256i*)(out + i), rotate32(c, rv, letter));
+    }
+    rotateSSSE3(out + i, in + i, n - i, r);
+}
+
+// One 16-byte block of keyed rotation: the exclusive prefix count of letters picks each letter's
+// key byte out of stream[j .. j+15] with pshufb
+__attribute__((target("ssse3")))
+static inline size_t keyedBlock16(unsigned char* out, const unsigned char* in,
+                                  const unsigned char* stream, size_t period, size_t j) {
+    __m128i c = _mm_loadu_si128((const __m128i*)in);
+    __m128i lower;
+    __m128i letter = letters16(c, lower);
+
+    __m128i ones = _mm_and_si128(letter, _mm_set1_epi8(1));
+    __m128i incl = _mm_add_epi8(ones, _mm_slli_si128(ones, 1));
+    incl = _mm_add_epi8(incl, _mm_slli_si128(incl, 2));
+    incl = _mm_add_epi8(incl, _mm_slli_si128(incl, 4));
+    incl = _mm_add_epi8(incl, _mm_slli_si128(incl, 8));
+    __m128i excl = _mm_sub_epi8(incl, ones);
+
+    __m128i rv = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(stream + j)), excl);
+    _mm_storeu_si128((__m128i*)out, rotate16(c, rv, letter));
+    return (j + __builtin_popcount(_mm_movemask_epi8(letter))) % period;
+}
+
+__attribute__((target("ssse3")))
+static size_t rotateKeyedSSSE3(unsigned char* out, const unsigned char* in, size_t n,
+                               const unsigned char* stream, size_t period, size_t j) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) j = keyedBlock16(out + i, in + i, stream, period, j);
+    return rotateKeyedScalar(out + i, in + i, n - i, stream, period, j);
+}
+
+// All-letter 32-byte blocks take the key bytes straight from the stream, mixed blocks go 16 at a time
+__attribute__((target("avx2")))
+static size_t rotateKeyedAVX2(unsigned char* out, const unsigned char* in, size_t n,
+                              const unsigned char* stream, size_t period, size_t j) {
+    size_t i = 0;
+    __m256i letter;
+    for (; i + 32 <= n; i += 32) {
+        __m256i c = _mm256_loadu_si256((const __m256i*)(in + i));
+        __m256i rv = _mm256_loadu_si256((const __m256i*)(stream + j));
+        __m256i res = rotate32(c, rv, letter);
+        if (_mm256_movemask_epi8(letter) == -1) {
+            _mm256_storeu_si256((__m256i*)(out + i), res);
+            j = (j + 32) % period;
+        } else {
+            j = keyedBlock16(out + i, in + i, stream, period, j);
+            j = keyedBlock16(out + i + 16, in + i + 16, stream, period, j);
+        }
+    }
+    return rotateKeyedSSSE3(out + i, in + i, n - i, stream, period, j);
+}
+#endif
+
+typedef void (*RotateKernel)(unsigned char*, const unsigned char*, size_t, unsigned);
+typedef size_t (*RotateKeyedKernel)(unsigned char*, const unsigned char*, size_t, const unsigned char*, size_t, size_t);
+
+struct LetterDispatch {
+    RotateKernel rotate;
+    RotateKeyedKernel keyed;
+    const char* name;
+};
+
+static LetterDispatch pickLetterKernels() {
+#ifdef LETTERS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return { rotateAVX2, rotateKeyedAVX2, "avx2" };
+    if (__builtin_cpu_supports("ssse3")) return { rotateSSSE3, rotateKeyedSSSE3, "ssse3" };
+#endif
+    return { rotateScalar, rotateKeyedScalar, "scalar" };
+}
+
+static const LetterDispatch& letterDispatch() {
+    static const LetterDispatch d = pickLetterKernels();
+    return d;
+}
+
+void rotateLetters(unsigned char* out, const unsigned char* in, size_t n, unsigned r) {
+    letterDispatch().rotate(out, in, n, r);
+}
+
+size_t rotateLettersKeyed(unsigned char* out, const unsigned char* in, size_t n,
+                          const unsigned char* stream, size_t period, size_t j) {
+    return letterDispatch().keyed(out, in, n, stream, period, j);
+}
+
+const char* letterKernelName() {
+    return letterDispatch().name;
+}
+
+
+VigenereKey::VigenereKey(const std::string& key) : period(key.size()), encRotation(true), decRotation(true) {
+    if (key.empty()) {
+        throw std::runtime_error("Vigenere key must not be empty");
+    }
+
+    shifts.resize(period);
+    std::vector<unsigned char> enc(period), dec(period);
+    for (size_t i = 0; i < period; i++) {
+        int k = tolower(key[i]) - 'a';
+        shifts[i] = k;
+        // (x + k) % 26 and (x - k + 26) % 26 are rotations of x in 0..25 only for these k
+        if (k >= 0) enc[i] = (unsigned char)(k % 26);
+        else encRotation = false;
+        if (k <= 26) dec[i] = (unsigned char)((26 - k) % 26);
+        else decRotation = false;
+    }
+
+    // repeat out to period + 32 bytes so a kernel can load 32 key bytes from any position
+    size_t len = period + 32;
+    encStream.resize(len);
+    decStream.resize(len);
+    for (size_t i = 0; i < len; i++) {
+        encStream[i] = enc[i % period];
+        decStream[i] = dec[i % period];
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Letter-rotation kernels behind the shift and Vigenere ciphers. Only ASCII A-Z / a-z are rotated
+// (case preserved), every other byte is copied unchanged. Dispatches once at runtime to AVX2,
+// SSSE3 or a portable loop. out may be the same buffer as in.
+
+// Rotate every letter forward by r (0..25)
+void rotateLetters(unsigned char* out, const unsigned char* in, size_t n, unsigned r);
+
+// Rotate the i-th letter by stream[(j + i) % period]; stream holds the period rotations (0..25)
+// repeated out to at least period + 32 bytes. Returns the key position after the last letter.
+size_t rotateLettersKeyed(unsigned char* out, const unsigned char* in, size_t n,
+                          const unsigned char* stream, size_t period, size_t j);
+
+// Name of the kernel in use ("avx2", "ssse3" or "scalar")
+const char* letterKernelName();
+
+
+// Vigenere key compiled once: per-position shifts and the rotation streams for both directions
+struct VigenereKey {
+    explicit VigenereKey(const std::string& key);
+
+    size_t period;
+    std::vector<int> shifts;                 // tolower(key[i]) - 'a', as the string functions use it
+    std::vector<unsigned char> encStream;    // encryption rotations, repeated to period + 32 bytes
+    std::vector<unsigned char> decStream;    // decryption rotations, same layout
+    bool encRotation;                        // every shift is a plain rotation when encrypting (shift >= 0)
+    bool decRotation;                        // ... when decrypting (shift <= 26)
+};
@@ -0,0 +1,435 @@
+#include "cryptanalysis.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <stdexcept>
+#include <NTL/mat_ZZ_p.h>
+
+// Public-domain sample used for the default trigram model
+static const char* ENGLISH_SAMPLE =
+    "When in the Course of human events, it becomes necessary for one people to dissolve the political "
+    "bands which have connected them with another, and to assume among the powers of the earth, the "
+    "separate and equal station to which the Laws of Nature and of Nature's God entitle them, a decent "
+    "respect to the opinions of mankind requires that they should declare the causes which impel them to "
+    "the separation. We hold these truths to be self-evident, that all men are created equal, that they "
+    "are endowed by their Creator with certain unalienable Rights, that among these are Life, Liberty and "
+    "the pursuit of Happiness. That to secure these rights, Governments are instituted among Men, deriving "
+    "their just powers from the consent of the governed, That whenever any Form of Government becomes "
+    "destructive of these ends, it is the Right of the People to alter or to abolish it, and to institute "
+    "new Government, laying its foundation on such principles and organizing its powers in such form, as "
+    "to them shall seem most likely to effect their Safety and Happiness. "
+    "Four score and seven years ago our fathers brought forth on this continent, a new nation, conceived "
+    "in Liberty, and dedicated to the proposition that all men are created equal. Now we are engaged in a "
+    "great civil war, testing whether that nation, or any nation so conceived and so dedicated, can long "
+    "endure. We are met on a great battle-field of that war. We have come to dedicate a portion of that "
+    "field, as a final resting place for those who here gave their lives that that nation might live. It "
+    "is altogether fitting and proper that we should do this. But, in a larger sense, we can not dedicate, "
+    "we can not consecrate, we can not hallow this ground. The brave men, living and dead, who struggled "
+    "here, have consecrated it, far above our poor power to add or detract. The world will little note, "
+    "nor long remember what we say here, but it can never forget what they did here. It is for us the "
+    "living, rather, to be dedicated here to the unfinished work which they who fought here have thus far "
+    "so nobly advanced. It is rather for us to be here dedicated to the great task remaining before us, "
+    "that from these honored dead we take increased devotion to that cause for which they gave the last "
+    "full measure of devotion, that we here highly resolve that these dead shall not have died in vain, "
+    "that this nation, under God, shall have a new birth of freedom, and that government of the people, "
+    "by the people, for the people, shall not perish from the earth.";
+
+// English letter frequencies (percent), a..z
+static const double ENGLISH_FREQ[26] = {
+    8.167, 1.492, 2.782, 4.253, 12.702, 2.228, 2.015, 6.094, 6.966, 0.153, 0.772, 4.025, 2.406,
+    6.749, 7.507, 1.929, 0.095, 5.987, 6.327, 9.056, 2.758, 0.978, 2.360, 0.150, 1.974, 0.074
+};
+
+static const unsigned char NOT_LETTER = 255;
+
+static inline unsigned char letterIndex(char c) {
+    if (c >= 'A' && c <= 'Z') return (unsigned char)(c - 'A');
+    if (c >= 'a' && c <= 'z') return (unsigned char)(c - 'a');
+    return NOT_LETTER;
+}
+
+// Letter indices of the letters of s, in order
+static vector<unsigned char> letterStream(const string& s) {
+    vector<unsigned char> v;
+    v.reserve(s.size());
+    for (char c : s) {
+        unsigned char x = letterIndex(c);
+        if (x != NOT_LETTER) v.push_back(x);
+    }
+    return v;
+}
+
+
+NgramScorer::NgramScorer(const string& corpus) : tri(26 * 26 * 26), bi(26 * 26) {
+    vector<unsigned char> v = letterStream(corpus);
+    vector<double> c3(26 * 26 * 26, 0), c2(26 * 26, 0);
+    for (size_t i = 0; i < v.size(); i++) {
+        if (i >= 1) c2[v[i - 1] * 26 + v[i]]++;
+        if (i >= 2) c3[(v[i - 2] * 26 + v[i - 1]) * 26 + v[i]]++;
+    }
+
+    // back off trigram -> bigram -> standard letter frequencies, K pseudo-counts at each level
+    const double K = 4;
+    double p1[26];
+    for (int c = 0; c < 26; c++) {
+        p1[c] = ENGLISH_FREQ[c] / 100;
+        uni[c] = (float)log(p1[c]);
+    }
+    for (int b = 0; b < 26; b++) {
+        double ctx = 0;
+        for (int c = 0; c < 26; c++) ctx += c2[b * 26 + c];
+        for (int c = 0; c < 26; c++) bi[b * 26 + c] = (float)log((c2[b * 26 + c] + K * p1[c]) / (ctx + K));
+    }
+    for (int ab = 0; ab < 26 * 26; ab++) {
+        double ctx = 0;
+        for (int c = 0; c < 26; c++) ctx += c3[ab * 26 + c];
+        for (int c = 0; c < 26; c++) {
+            double pb = exp(bi[(ab % 26) * 26 + c]);
+            tri[ab * 26 + c] = (float)log((c3[ab * 26 + c] + K * pb) / (ctx + K));
+        }
+    }
+}
+
+const NgramScorer& NgramScorer::english() {
+    static const NgramScorer s(ENGLISH_SAMPLE);
+    return s;
+}
+
+double NgramScorer::score(const unsigned char* v, size_t n) const {
+    double s = 0;
+    int a = -1, b = -1;
+    for (size_t i = 0; i < n; i++) {
+        int c = v[i];
+        if (c >= 26) {
+            s += nonLetter;
+            continue;
+        }
+        if (b < 0) s += uni[c];
+        else if (a < 0) s += bi[b * 26 + c];
+        else s += tri[(a * 26 + b) * 26 + c];
+        a = b;
+        b = c;
+    }
+    return s;
+}
+
+
+Cryptanalyst::Cryptanalyst(unsigned threads, const NgramScorer& scorer)
+    : threads(threads), scorer(scorer), pool(new WorkStealingPool(threads)), cipher(new appliedCryptography) {}
+
+string Cryptanalyst::crackShift(const string& ciphertext) const {
+    return cipher->shiftDecrypt(ciphertext, breakShift(ciphertext));
+}
+
+string Cryptanalyst::crackVigenere(const string& ciphertext, size_t maxPeriod) const {
+    return cipher->vigenereDecrypt(ciphertext, breakVigenere(ciphertext, maxPeriod));
+}
+
+string Cryptanalyst::crackHill2(const string& ciphertext) const {
+    return cipher->hillDecrypt(ciphertext, breakHill2(ciphertext));
+}
+
+// Per-worker best candidate, merged after the parallel loop
+struct Best {
+    double score = -HUGE_VAL;
+    size_t index = 0;
+};
+
+static Best pickBest(const vector<Best>& best) {
+    Best b;
+    for (const Best& x : best) {
+        if (x.score > b.score || (x.score == b.score && x.index < b.index)) b = x;
+    }
+    return b;
+}
+
+int Cryptanalyst::breakShift(const string& ciphertext) const {
+    vector<unsigned char> L = letterStream(ciphertext);
+    unsigned w = pool->size();
+    vector<vector<unsigned char>> scratch(w, vector<unsigned char>(L.size()));
+    vector<Best> best(w);
+
+    pool->run(26, 1, [&](size_t begin, size_t end, unsigned t) {
+        unsigned char* buf = scratch[t].data();
+        for (size_t k = begin; k < end; k++) {
+            for (size_t i = 0; i < L.size(); i++) buf[i] = (unsigned char)((L[i] + 26 - k) % 26);
+            double s = scorer.score(buf, L.size());
+            if (s > best[t].score) best[t] = Best{ s, k };
+        }
+    });
+    return (int)pickBest(best).index;
+}
+
+vector<PeriodEstimate> Cryptanalyst::estimatePeriods(const string& ciphertext, size_t maxPeriod) const {
+    vector<unsigned char> L = letterStream(ciphertext);
+    maxPeriod = max<size_t>(1, min(maxPeriod, L.size() / 2));
+    vector<PeriodEstimate> est(maxPeriod);
+
+    // index of coincidence per period, one period per work item
+    pool->run(maxPeriod, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t p = begin + 1; p <= end; p++) {
+            double sum = 0;
+            for (size_t col = 0; col < p; col++) {
+                long counts[26] = { 0 };
+                long n = 0;
+                for (size_t i = col; i < L.size(); i += p) {
+                    counts[L[i]]++;
+                    n++;
+                }
+                if (n < 2) continue;
+                double pairs = 0;
+                for (long c : counts) pairs += (double)c * (c - 1);
+                sum += 26 * pairs / ((double)n * (n - 1));
+            }
+            est[p - 1] = PeriodEstimate{ p, sum / p, 0 };
+        }
+    });
+
+    // Kasiski: distances between repeated trigrams, counted against every period dividing them
+    vector<long> last(26 * 26 * 26, -1);
+    for (size_t i = 2; i < L.size(); i++) {
+        size_t t = (L[i - 2] * 26 + L[i - 1]) * 26 + L[i];
+        if (last[t] >= 0) {
+            size_t dist = i - last[t];
+            for (size_t p = 1; p <= maxPeriod; p++) {
+                if (dist % p == 0) est[p - 1].kasiski++;
+            }
+        }
+        last[t] = (long)i;
+    }
+
+    // multiples of the period share its IoC but divide fewer Kasiski distances; divisors get both a lower
+    // IoC and more distances, so weight the IoC by the distance share
+    long maxKas = 1;
+    for (size_t p = 2; p <= maxPeriod; p++) maxKas = max(maxKas, est[p - 1].kasiski);
+    auto rank = [&](const PeriodEstimate& e) {
+        double kas = e.period == 1 ? 0 : (double)e.kasiski / maxKas;
+        return e.ioc * (1 + 0.25 * kas);
+    };
+    stable_sort(est.begin(), est.end(), [&](const PeriodEstimate& a, const PeriodEstimate& b) {
+        return rank(a) > rank(b);
+    });
+    return est;
+}
+
+// Letters of L decrypted with the repeating key k of period p
+static inline void vigenereLetters(unsigned char* out, const vector<unsigned char>& L, const unsigned char* k, size_t p) {
+    size_t j = 0;
+    for (size_t i = 0; i < L.size(); i++) {
+        out[i] = (unsigned char)((L[i] + 26 - k[j]) % 26);
+        if (++j == p) j = 0;
+    }
+}
+
+string Cryptanalyst::breakVigenere(const string& ciphertext, size_t maxPeriod) const {
+    vector<unsigned char> L = letterStream(ciphertext);
+    if (L.empty()) return "a";
+
+    vector<PeriodEstimate> periods = estimatePeriods(ciphertext, maxPeriod);
+    unsigned w = pool->size();
+    vector<vector<unsigned char>> scratch(w, vector<unsigned char>(L.size()));
+
+    vector<unsigned char> bestKey;
+    double bestScore = -HUGE_VAL;
+    for (size_t cand = 0; cand < min<size_t>(3, periods.size()); cand++) {
+        size_t p = periods[cand].period;
+
+        // each column is a shift cipher: closest shift to English frequencies by chi-squared
+        vector<unsigned char> key(p);
+        for (size_t col = 0; col < p; col++) {
+            double counts[26] = { 0 };
+            double n = 0;
+            for (size_t i = col; i < L.size(); i += p) {
+                counts[L[i]]++;
+                n++;
+            }
+            double bestChi = HUGE_VAL;
+            for (int s = 0; s < 26; s++) {
+                double chi = 0;
+                for (int e = 0; e < 26; e++) {
+                    double expect = n * ENGLISH_FREQ[e] / 100;
+                    double d = counts[(e + s) % 26] - expect;
+                    chi += d * d / expect;
+                }
+                if (chi < bestChi) {
+                    bestChi = chi;
+                    key[col] = (unsigned char)s;
+                }
+            }
+        }
+
+        // n-gram refinement: retry all 26 letters at each position while the score improves
+        vigenereLetters(scratch[0].data(), L, key.data(), p);
+        double score = scorer.score(scratch[0].data(), L.size());
+        vector<vector<unsigned char>> trial(w);
+        for (int pass = 0; pass < 3; pass++) {
+            bool improved = false;
+            for (size_t pos = 0; pos < p; pos++) {
+                for (auto& k : trial) k = key;
+                vector<Best> best(w);
+                pool->run(26, 1, [&](size_t begin, size_t end, unsigned t) {
+                    for (size_t s = begin; s < end; s++) {
+                        trial[t][pos] = (unsigned char)s;
+                        vigenereLetters(scratch[t].data(), L, trial[t].data(), p);
+                        double sc = scorer.score(scratch[t].data(), L.size());
+                        if (sc > best[t].score) best[t] = Best{ sc, s };
+                    }
+                });
+                Best b = pickBest(best);
+                if (b.score > score + 1e-9) {
+                    score = b.score;
+                    key[pos] = (unsigned char)b.index;
+                    improved = true;
+                }
+            }
+            if (!improved) break;
+        }
+
+        // a longer period has to beat the shorter one clearly, not by overfitting extra key letters
+        if (bestKey.empty() || score > bestScore + 0.01 * fabs(bestScore)) {
+            bestScore = score;
+            bestKey = key;
+        }
+    }
+
+    // report the shortest repeating unit of the key
+    size_t p = bestKey.size();
+    for (size_t d = 1; d < p; d++) {
+        if (p % d != 0) continue;
+        bool repeats = true;
+        for (size_t i = d; i < p && repeats; i++) repeats = bestKey[i] == bestKey[i - d];
+        if (repeats) {
+            p = d;
+            break;
+        }
+    }
+
+    string key(p, 'a');
+    for (size_t i = 0; i < p; i++) key[i] = char('a' + bestKey[i]);
+    return key;
+}
+
+
+static const long HILL_MOD = HillKey::MOD;
+
+static inline long hillMod(long x) {
+    x %= HILL_MOD;
+    return x < 0 ? x + HILL_MOD : x;
+}
+
+// Character values as hillEncrypt / hillDecrypt use them
+static inline unsigned char hillPlainValue(char c) {
+    int x = (signed char)c;
+    return (unsigned char)hillMod((x >= 0 ? toupper(x) : x) - 'A');
+}
+
+static inline unsigned char hillCipherValue(char c) {
+    return (unsigned char)hillMod((signed char)c - 'A');
+}
+
+static inline long hillInverse(long a) {
+    long r = 1;
+    for (long e = 0; e < HILL_MOD - 2; e++) r = r * a % HILL_MOD;
+    return r;
+}
+
+// HillKey from a row-major n x n matrix of values 0..30
+static HillKey makeHillKey(const vector<long>& m, long n) {
+    ZZ_pPush push(conv<ZZ>(HILL_MOD));
+    mat_ZZ_p key;
+    key.SetDims(n, n);
+    for (long i = 0; i < n; i++) {
+        for (long j = 0; j < n; j++) key[i][j] = m[i * n + j];
+    }
+    return HillKey(key);
+}
+
+HillKey Cryptanalyst::recoverHillKey(const string& plaintext, const string& ciphertext, long n) const {
+    if (n <= 0) throw runtime_error("Hill key size must be positive");
+    size_t blocks = min(plaintext.size(), ciphertext.size()) / n;
+
+    // rows [P_b | C_b]; reducing P^T to the identity turns the right half into K^T since C_b = K P_b
+    vector<vector<long>> rows(blocks, vector<long>(2 * n));
+    for (size_t b = 0; b < blocks; b++) {
+        for (long j = 0; j < n; j++) {
+            rows[b][j] = hillPlainValue(plaintext[b * n + j]);
+            rows[b][n + j] = hillCipherValue(ciphertext[b * n + j]);
+        }
+    }
+
+    size_t r = 0;
+    for (long col = 0; col < n; col++) {
+        size_t piv = r;
+        while (piv < blocks && rows[piv][col] == 0) piv++;
+        if (piv == blocks) {
+            throw runtime_error("Known plaintext does not determine the Hill key");
+        }
+        swap(rows[piv], rows[r]);
+        long inv = hillInverse(rows[r][col]);
+        for (long j = 0; j < 2 * n; j++) rows[r][j] = rows[r][j] * inv % HILL_MOD;
+        for (size_t i = 0; i < blocks; i++) {
+            long f = rows[i][col];
+            if (i == r || f == 0) continue;
+            for (long j = 0; j < 2 * n; j++) rows[i][j] = hillMod(rows[i][j] - f * rows[r][j]);
+        }
+        r++;
+    }
+
+    vector<long> K(n * n);
+    for (long i = 0; i < n; i++) {
+        for (long j = 0; j < n; j++) K[i * n + j] = rows[j][n + i];
+    }
+    return makeHillKey(K, n);
+}
+
+HillKey Cryptanalyst::breakHill2(const string& ciphertext, uint64_t* keysTried) const {
+    const size_t ROWS = HILL_MOD * HILL_MOD;
+    size_t blocks = ciphertext.size() / 2;
+    if (blocks == 0) throw runtime_error("Ciphertext too short to attack");
+
+    // every decryption row (x, y) applied to every block, as scorer symbols
+    vector<unsigned char> rowOut(ROWS * blocks);
+    for (size_t r = 0; r < ROWS; r++) {
+        long x = r / HILL_MOD, y = r % HILL_MOD;
+        for (size_t b = 0; b < blocks; b++) {
+            long v = (x * hillCipherValue(ciphertext[2 * b]) + y * hillCipherValue(ciphertext[2 * b + 1])) % HILL_MOD;
+            rowOut[r * blocks + b] = (unsigned char)v;     // 26..30 are non-letters to the scorer
+        }
+    }
+
+    unsigned w = pool->size();
+    vector<vector<unsigned char>> scratch(w, vector<unsigned char>(2 * blocks));
+    vector<Best> best(w);
+    vector<uint64_t> tried(w, 0);
+
+    pool->run(ROWS, 8, [&](size_t begin, size_t end, unsigned t) {
+        unsigned char* buf = scratch[t].data();
+        for (size_t r1 = begin; r1 < end; r1++) {
+            long a = r1 / HILL_MOD, b = r1 % HILL_MOD;
+            const unsigned char* top = &rowOut[r1 * blocks];
+            for (size_t i = 0; i < blocks; i++) buf[2 * i] = top[i];
+            for (size_t r2 = 0; r2 < ROWS; r2++) {
+                long c = r2 / HILL_MOD, d = r2 % HILL_MOD;
+                if ((a * d - b * c) % HILL_MOD == 0) continue;
+                const unsigned char* bottom = &rowOut[r2 * blocks];
+                for (size_t i = 0; i < blocks; i++) buf[2 * i + 1] = bottom[i];
+                double s = scorer.score(buf, 2 * blocks);
+                tried[t]++;
+                if (s > best[t].score) best[t] = Best{ s, r1 * ROWS + r2 };
+            }
+        }
+    });
+
+    if (keysTried) {
+        *keysTried = 0;
+        for (uint64_t n : tried) *keysTried += n;
+    }
+
+    size_t idx = pickBest(best).index;
+    size_t r1 = idx / ROWS, r2 = idx % ROWS;
+    vector<long> D = { long(r1 / HILL_MOD), long(r1 % HILL_MOD), long(r2 / HILL_MOD), long(r2 % HILL_MOD) };
+    HillKey dec = makeHillKey(D, 2);
+    vector<long> K(dec.inverse().begin(), dec.inverse().end());
+    return makeHillKey(K, 2);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "assign.hpp"
+#include "parallel.hpp"
+
+// English trigram model: log P(c | a b) over the letters of a corpus, backed off to unigram
+// frequencies. Non-letters are skipped when counting and cost `nonLetter` each when scoring.
+class NgramScorer {
+public:
+    explicit NgramScorer(const string& corpus);
+    static const NgramScorer& english();         // built once from a small embedded sample
+
+    // Higher is more English-like. v holds letter indices 0..25; anything larger is a non-letter.
+    double score(const unsigned char* v, size_t n) const;
+
+    float nonLetter = -4.0f;
+
+private:
+    vector<float> tri;      // log P(c | a b), index (a * 26 + b) * 26 + c
+    vector<float> bi;       // log P(c | b), index b * 26 + c
+    float uni[26];          // log P(c)
+};
+
+// One candidate Vigenere period: average index of coincidence over the columns (26 * IoC, so
+// about 1.7 for English and 1.0 for random letters) and the number of Kasiski distances it divides
+struct PeriodEstimate {
+    size_t period;
+    double ioc;
+    long kasiski;
+};
+
+// Breaks the classical ciphers of appliedCryptography. Candidate scoring runs on letter-index buffers
+// allocated once per call (per worker), and work is split over a work-stealing pool the analyst starts
+// once and reuses. break* return keys; crack* return the plaintext, decrypted with the recovered key by
+// shiftDecrypt / vigenereDecrypt / hillDecrypt.
+// One analyst breaks one ciphertext at a time: the methods are const, but concurrent calls on the same
+// analyst queue for its pool. Give each thread its own Cryptanalyst to break several at once.
+class Cryptanalyst {
+public:
+    explicit Cryptanalyst(unsigned threads = 0, const NgramScorer& scorer = NgramScorer::english());
+
+    // Shift: returns the key in 0..25 for shiftDecrypt
+    int breakShift(const string& ciphertext) const;
+
+    // Vigenere: candidate periods 1..maxPeriod, most likely first
+    vector<PeriodEstimate> estimatePeriods(const string& ciphertext, size_t maxPeriod = 20) const;
+    // Key (lower-case letters) for vigenereDecrypt: per-column chi-squared, then n-gram refinement,
+    // trying the best few periods
+    string breakVigenere(const string& ciphertext, size_t maxPeriod = 20) const;
+
+    // Hill, known plaintext: solves K from n independent blocks of plain/cipher (as hillEncrypt maps them).
+    // Throws runtime_error if the known text doesn't span an invertible block matrix.
+    HillKey recoverHillKey(const string& plaintext, const string& ciphertext, long n) const;
+    // Hill 2x2, ciphertext only: every invertible decryption matrix is scored. keysTried, if given,
+    // receives the number of candidate keys examined.
+    HillKey breakHill2(const string& ciphertext, uint64_t* keysTried = nullptr) const;
+
+    string crackShift(const string& ciphertext) const;
+    string crackVigenere(const string& ciphertext, size_t maxPeriod = 20) const;
+    string crackHill2(const string& ciphertext) const;
+
+    const unsigned threads;     // as requested, 0 = one per hardware thread
+
+private:
+    const NgramScorer& scorer;
+    unique_ptr<WorkStealingPool> pool;
+    unique_ptr<appliedCryptography> cipher;
+};
@@ -0,0 +1,493 @@
+// Benchmark suite over every appliedCryptography method, machine-readable
+// build: cmake target crypto_bench (see CMakeLists.txt)
+// usage: crypto_bench [--seconds S] [--out FILE] [classical] [otp] [dh] [elgamal] [ec]   (no groups runs everything)
+//
+// Prints one JSON document: the run's build and kernel metadata, then one record per method and
+// parameter set with ops/sec, ns/op and heap allocations per op (null when they can't be counted).
+// Every record is measured after one warm-up call, so lazily built tables and per-thread arenas
+// are not charged to it.
+#include "assign.hpp"
+#include "alloccount.hpp"
+#include "classical.hpp"
+#include "drbg.hpp"
+#include "sha256.hpp"
+#include "simdxor.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+using namespace std;
+using namespace NTL;
+
+// NIST P-256
+static const char* P256_P  = "115792089210356248762697446949407573530086143415290314195533631308867097853951";
+static const char* P256_B  = "41058363725152142129326129780047268409114441015993725554835256314039467401291";
+static const char* P256_GX = "48439561293906451759052585252797914202762949526041747995844080717082404635286";
+static const char* P256_GY = "36134250956749795798585127919587881956611106672985015071877198253568414405109";
+static const char* P256_N  = "115792089210356248762697446949407573529996955224135760342422259061068512044369";
+
+// secp256k1: y^2 = x^3 + 7
+static const char* K256_P  = "115792089237316195423570985008687907853269984665640564039457584007908834671663";
+static const char* K256_GX = "55066263022277343669578718895168534326250603453777594175500187360389116729240";
+static const char* K256_GY = "32670510020758816978083085130507043184471273380659243275938904335757337482424";
+static const char* K256_N  = "115792089237316195423570985008687907852837564279074904382605163141518161494337";
+
+
+// One parameter of a record, value already in JSON form
+typedef pair<string, string> Param;
+
+Param num(const string& name, long v) {
+    return Param(name, to_string(v));
+}
+
+string jsonString(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c < 0x20) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            out += esc;
+            continue;
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+Param str(const string& name, const string& v) {
+    return Param(name, jsonString(v));
+}
+
+struct Record {
+    string group, method;
+    vector<Param> params;
+    long iterations;
+    double seconds;
+    long allocs;
+};
+
+class Suite {
+public:
+    Suite(double seconds, const vector<string>& groups) : seconds(seconds), groups(groups) {}
+
+    bool wants(const string& group) const {
+        if (groups.empty()) return true;
+        for (const string& g : groups) {
+            if (g == group) return true;
+        }
+        return false;
+    }
+
+    // f() once to warm up, then batches of calls for about `seconds`
+    template<class F>
+    void run(const string& group, const string& method, const vector<Param>& params, F f) {
+        using clock = chrono::steady_clock;
+        f();
+        long allocs = heapAllocations();
+        long ops = 0, batch = 1;
+        auto start = clock::now();
+        double elapsed = 0;
+        do {
+            for (long i = 0; i < batch; i++) f();
+            ops += batch;
+            elapsed = chrono::duration<double>(clock::now() - start).count();
+            if (elapsed < seconds / 100) batch *= 2;
+        } while (elapsed < seconds);
+        records.push_back({ group, method, params, ops, elapsed, heapAllocations() - allocs });
+    }
+
+    void section(const string& name) const {
+        cerr << "crypto_bench: " << name << endl;
+    }
+
+    void writeJSON(ostream& out) const {
+        char stamp[32];
+        time_t now = time(nullptr);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+        bool counting = countingHeapAllocations();
+
+        out << "{\n";
+        out << "  \"suite\": \"crypto_bench\",\n";
+        out << "  \"schema_version\": 1,\n";
+        out << "  \"timestamp\": " << jsonString(stamp) << ",\n";
+        out << "  \"compiler\": " << jsonString(__VERSION__) << ",\n";
+#ifdef NDEBUG
+        out << "  \"assertions\": false,\n";
+#else
+        out << "  \"assertions\": true,\n";
+#endif
+        out << "  \"hardware_threads\": " << thread::hardware_concurrency() << ",\n";
+        out << "  \"seconds_per_case\": " << seconds << ",\n";
+        out << "  \"alloc_counting\": " << (counting ? "true" : "false") << ",\n";
+        out << "  \"kernels\": { \"xor\": " << jsonString(xorKernelName()) << ", \"letters\": " << jsonString(letterKernelName())
+            << ", \"chacha\": " << jsonString(ChaChaDRBG::kernelName()) << ", \"sha256\": " << jsonString(Sha256::kernelName())
+            << " },\n";
+        out << "  \"results\": [";
+        for (size_t i = 0; i < records.size(); i++) {
+            const Record& r = records[i];
+            out << (i ? ",\n" : "\n") << "    { \"group\": " << jsonString(r.group) << ", \"method\": " << jsonString(r.method)
+                << ", \"params\": {";
+            for (size_t k = 0; k < r.params.size(); k++) {
+                out << (k ? ", " : " ") << jsonString(r.params[k].first) << ": " << r.params[k].second;
+            }
+            out << (r.params.empty() ? "}" : " }");
+            out << ", \"iterations\": " << r.iterations << ", \"ops_per_sec\": " << r.iterations / r.seconds
+                << ", \"ns_per_op\": " << r.seconds * 1e9 / r.iterations << ", \"allocs_per_op\": ";
+            if (counting) out << double(r.allocs) / r.iterations;
+            else out << "null";
+            out << " }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+    double seconds;
+    vector<string> groups;
+    vector<Record> records;
+};
+
+
+string randomText(size_t n) {
+    static const char letters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ abcdefghijklmnopqrstuvwxyz";
+    string s(n, ' ');
+    for (auto& c : s) c = letters[threadDRBG().next64() % (sizeof(letters) - 1)];
+    return s;
+}
+
+mat_ZZ_p randomHillKey(long n) {
+    ZZ_pPush push(ZZ(HillKey::MOD));
+    mat_ZZ_p key;
+    key.SetDims(n, n);
+    for (;;) {
+        for (long i = 0; i < n; i++) {
+            for (long j = 0; j < n; j++) key[i][j] = conv<ZZ_p>(threadDRBG().randomBnd(ZZ(HillKey::MOD)));
+        }
+        if (!IsZero(determinant(key))) return key;
+    }
+}
+
+// A `bits`-bit prime from a fixed seed, so every run benchmarks the same moduli
+ZZ benchPrime(long bits) {
+    unsigned char seed[32] = { 0 };
+    seed[0] = (unsigned char)bits;
+    seed[1] = (unsigned char)(bits >> 8);
+    ChaChaDRBG rng(seed);
+    ZZ p = rng.randomBnd(power2_ZZ(bits - 1)) + power2_ZZ(bits - 1);
+    if (!IsOdd(p)) p += 1;
+    while (!ProbPrime(p)) p += 2;
+    return p;
+}
+
+void benchClassical(Suite& suite, appliedCryptography& crypto) {
+    const string vigKey = "LEMON";
+    VigenereKey vk(vigKey);
+    mat_ZZ_p hill = randomHillKey(3);
+    HillKey hk(hill);
+    for (long len : { 64L, 1024L, 16384L, 262144L }) {
+        suite.section("classical, " + to_string(len) + " bytes");
+        vector<Param> at = { num("length", len) };
+        string text = randomText(len);
+        string shifted = crypto.shiftEncrypt(text, 3);
+        string vig = crypto.vigenereEncrypt(text, vk);
+        string hillEnc = crypto.hillEncrypt(text, hk);
+        suite.run("classical", "shiftEncrypt", at, [&] { crypto.shiftEncrypt(text, 3); });
+        suite.run("classical", "shiftDecrypt", at, [&] { crypto.shiftDecrypt(shifted, 3); });
+        suite.run("classical", "vigenereEncrypt", at, [&] { crypto.vigenereEncrypt(text, vigKey); });
+        suite.run("classical", "vigenereDecrypt", at, [&] { crypto.vigenereDecrypt(vig, vigKey); });
+        suite.run("classical", "vigenereEncrypt(VigenereKey)", at, [&] { crypto.vigenereEncrypt(text, vk); });
+        suite.run("classical", "vigenereDecrypt(VigenereKey)", at, [&] { crypto.vigenereDecrypt(vig, vk); });
+        vector<Param> hillAt = { num("length", len), num("n", hk.size()) };
+        suite.run("classical", "hillEncrypt", hillAt, [&] { crypto.hillEncrypt(text, hill); });
+        suite.run("classical", "hillDecrypt", hillAt, [&] { crypto.hillDecrypt(hillEnc, hill); });
+        suite.run("classical", "hillEncrypt(HillKey)", hillAt, [&] { crypto.hillEncrypt(text, hk); });
+        suite.run("classical", "hillDecrypt(HillKey)", hillAt, [&] { crypto.hillDecrypt(hillEnc, hk); });
+    }
+}
+
+void benchOTP(Suite& suite, appliedCryptography& crypto) {
+    for (long len : { 64L, 1024L, 16384L, 262144L }) {
+        suite.section("otp, " + to_string(len) + " bytes");
+        vector<Param> at = { num("length", len) };
+        string text = randomText(len);
+        string key = crypto.generateRandomKey(len);
+        string enc = crypto.otpEncrypt(text, key);
+        vector<unsigned char> buf(text.begin(), text.end());
+        const unsigned char* k = (const unsigned char*)key.data();
+        suite.run("otp", "generateRandomKey", at, [&] { crypto.generateRandomKey(len); });
+        suite.run("otp", "otpEncrypt", at, [&] { crypto.otpEncrypt(text, key); });
+        suite.run("otp", "otpDecrypt", at, [&] { crypto.otpDecrypt(enc, key); });
+        suite.run("otp", "otpXor", at, [&] { crypto.otpXor(buf.data(), (const unsigned char*)text.data(), len, k, len); });
+        suite.run("otp", "otpXorInPlace", at, [&] { crypto.otpXorInPlace(buf.data(), len, k, len); });
+    }
+}
+
+const long GROUP_BITS[] = { 512, 1024, 2048, 3072 };
+
+void benchDH(Suite& suite, appliedCryptography& crypto) {
+    for (long bits : GROUP_BITS) {
+        suite.section("dh, " + to_string(bits) + "-bit prime");
+        ZZ p = benchPrime(bits);
+        ZZ_pPush push(p);
+        vector<Param> at = { num("bits", bits) };
+        ZZ_p g(2);
+        ZZ a = threadDRBG().randomRange(ZZ(2), p - 2);
+        ZZ_p aP = conv<ZZ_p>(a);
+        ZZ_p A = crypto.diffiePublicKeyNTL(a, g);
+        ModExpTable T = crypto.precomputeDiffieBase(g);
+        vector<ZZ_p> received(16);
+        for (auto& r : received) r = crypto.diffiePublicKeyNTL(threadDRBG().randomRange(ZZ(2), p - 2), T);
+        suite.run("dh", "diffiePublicKeyNTL(ZZ_p)", at, [&] { crypto.diffiePublicKeyNTL(aP, g); });
+        suite.run("dh", "diffieSharedKeyNTL(ZZ_p)", at, [&] { crypto.diffieSharedKeyNTL(A, aP); });
+        suite.run("dh", "diffiePublicKeyNTL", at, [&] { crypto.diffiePublicKeyNTL(a, g); });
+        suite.run("dh", "diffieSharedKeyNTL", at, [&] { crypto.diffieSharedKeyNTL(A, a); });
+        suite.run("dh", "precomputeDiffieBase", { num("bits", bits), num("w", 4) }, [&] { crypto.precomputeDiffieBase(g); });
+        suite.run("dh", "diffiePublicKeyNTL(ModExpTable)", { num("bits", bits), num("w", 4) }, [&] { crypto.diffiePublicKeyNTL(a, T); });
+        suite.run("dh", "diffieSharedKeysParallel", { num("bits", bits), num("batch", received.size()) },
+                  [&] { crypto.diffieSharedKeysParallel(received, a); });
+    }
+}
+
+void benchElGamal(Suite& suite, appliedCryptography& crypto) {
+    for (long bits : GROUP_BITS) {
+        suite.section("elgamal, " + to_string(bits) + "-bit prime");
+        ZZ p = benchPrime(bits);
+        ZZ_pPush push(p);
+        vector<Param> at = { num("bits", bits) };
+        ZZ g(2);
+        ZZ_p gP(2);
+        ZZ x = threadDRBG().randomRange(ZZ(2), p - 2);
+        ZZ h = PowerMod(g, x, p);
+        ZZ_p hP = conv<ZZ_p>(h), xP = conv<ZZ_p>(x);
+        ZZ_p m = random_ZZ_p(), c1, c2;
+        crypto.elGamalEncrypt(gP, hP, m, c1, c2);
+        ElGamalEncryptor enc(gP, hP);
+        suite.run("elgamal", "generateRandomY", at, [&] { crypto.generateRandomY(); });
+        suite.run("elgamal", "elGamalEncrypt", at, [&] { crypto.elGamalEncrypt(gP, hP, m, c1, c2); });
+        suite.run("elgamal", "elGamalEncrypt(ElGamalEncryptor)", at, [&] { crypto.elGamalEncrypt(enc, m, c1, c2); });
+        suite.run("elgamal", "elGamalDecrypt", at, [&] { crypto.elGamalDecrypt(xP, c1, c2); });
+
+        ZZ msg = threadDRBG().randomBnd(p - 1), gamma, delta;
+        crypto.elGamalSign(p, g, x, msg, gamma, delta);
+        suite.run("elgamal", "elGamalSign", at, [&] { crypto.elGamalSign(p, g, x, msg, gamma, delta); });
+        suite.run("elgamal", "elGamalVerify", at, [&] { crypto.elGamalVerify(p, g, h, msg, gamma, delta); });
+        vector<ElGamalSigItem> items(64);
+        for (auto& it : items) {
+            it.m = threadDRBG().randomBnd(p - 1);
+            it.h = h;
+            crypto.elGamalSign(p, g, x, it.m, it.gamma, it.delta);
+        }
+        suite.run("elgamal", "elGamalVerifyBatch", { num("bits", bits), num("batch", items.size()) },
+                  [&] { crypto.elGamalVerifyBatch(p, g, items); });
+
+        string doc = randomText(1024);
+        MessageSource src = MessageSource::buffer(doc.data(), doc.size());
+        vector<Param> streamAt = { num("bits", bits), num("message_bytes", doc.size()) };
+        crypto.elGamalSignStream(p, g, x, src, gamma, delta);
+        suite.run("elgamal", "elGamalSignStream", streamAt, [&] { crypto.elGamalSignStream(p, g, x, src, gamma, delta); });
+        suite.run("elgamal", "elGamalVerifyStream", streamAt, [&] { crypto.elGamalVerifyStream(p, g, h, src, gamma, delta); });
+    }
+}
+
+// One curve configuration for the EC group
+struct CurveCase {
+    string name;
+    ZZ p, q;
+    ZZ a, b, gx, gy;
+    bool fixedWidth;
+};
+
+void benchCurve(Suite& suite, appliedCryptography& crypto, const CurveCase& c) {
+    ZZ_pPush push(c.p);
+    ZZ_p a = conv<ZZ_p>(c.a), b = conv<ZZ_p>(c.b);
+    crypto.initCurve(c.p, a, b, c.q);
+    crypto.useFixedWidthField(c.fixedWidth);
+    static const char* const fieldNames[] = { "zz_p", "p256", "secp256k1" };
+    string field = fieldNames[crypto.fieldBackendInUse()];
+    suite.section("ec, " + c.name + " (" + field + ")");
+    vector<Param> at = { str("curve", c.name), str("field", field) };
+    auto with = [&](const string& name, long v) {
+        vector<Param> ps = at;
+        ps.push_back(num(name, v));
+        return ps;
+    };
+
+    const ZZ& q = c.q;
+    ECPoint G(conv<ZZ_p>(c.gx), conv<ZZ_p>(c.gy));
+    FixedBaseTable T = crypto.precomputeFixedBase(G, q);
+    ZZ priv, priv2;
+    ECPoint Q, Q2;
+    crypto.keyGen(T, priv, Q);
+    crypto.keyGen(T, priv2, Q2);
+    ZZ k = threadDRBG().randomRange(ZZ(1), q - 1), k2 = threadDRBG().randomRange(ZZ(1), q - 1);
+    ECPointJ J = crypto.toJacobian(Q), J2 = crypto.scalarMultiplyJ(Q, k);
+    ECPoint out;
+
+    suite.run("ec", "initCurve", at, [&] { crypto.initCurve(c.p, a, b); crypto.useFixedWidthField(c.fixedWidth); });
+    crypto.initCurve(c.p, a, b, q);
+    crypto.useFixedWidthField(c.fixedWidth);
+    suite.run("ec", "isOnCurve", at, [&] { crypto.isOnCurve(Q); });
+    suite.run("ec", "pointAdd", at, [&] { crypto.pointAdd(Q, Q2); });
+    suite.run("ec", "pointDouble", at, [&] { crypto.pointDouble(Q); });
+    suite.run("ec", "pointNeg", at, [&] { crypto.pointNeg(Q); });
+    suite.run("ec", "pointAddInto", at, [&] { crypto.pointAddInto(out, Q, Q2); });
+    suite.run("ec", "pointDoubleInto", at, [&] { crypto.pointDoubleInto(out, Q); });
+    suite.run("ec", "toJacobian", at, [&] { crypto.toJacobian(Q); });
+    suite.run("ec", "toAffine", at, [&] { crypto.toAffine(J2); });
+    suite.run("ec", "jacobianDouble", at, [&] { crypto.jacobianDouble(J2); });
+    suite.run("ec", "jacobianAdd", at, [&] { crypto.jacobianAdd(J, J2); });
+    suite.run("ec", "jacobianAddMixed", at, [&] { crypto.jacobianAddMixed(J2, Q2); });
+    vector<ECPointJ> many(64);
+    for (auto& P : many) P = crypto.scalarMultiplyJ(G, threadDRBG().randomRange(ZZ(1), q - 1));
+    suite.run("ec", "normalizeBatch", with("batch", many.size()), [&] { crypto.normalizeBatch(many); });
+
+    long w = crypto.windowWidth();
+    suite.run("ec", "oddMultiples", with("w", w), [&] { crypto.oddMultiples(Q, w); });
+    suite.run("ec", "scalarMultiply", with("w", w), [&] { crypto.scalarMultiply(Q, k); });
+    suite.run("ec", "scalarMultiplyInto", with("w", w), [&] { crypto.scalarMultiplyInto(out, Q, k); });
+    suite.run("ec", "scalarMultiplyJ", with("w", w), [&] { crypto.scalarMultiplyJ(Q, k); });
+    suite.run("ec", "multiScalarMultiply", with("w", w), [&] { crypto.multiScalarMultiply(G, k, Q, k2); });
+    suite.run("ec", "multiScalarMultiplyJ", with("w", w), [&] { crypto.multiScalarMultiplyJ(G, k, Q, k2); });
+    suite.run("ec", "precomputeFixedBase", with("w", T.w), [&] { crypto.precomputeFixedBase(G, q); });
+    suite.run("ec", "fixedBaseMultiply", with("w", T.w), [&] { crypto.fixedBaseMultiply(T, k); });
+    suite.run("ec", "fixedBaseMultiplyJ", with("w", T.w), [&] { crypto.fixedBaseMultiplyJ(T, k); });
+
+    ZZ kp;
+    ECPoint kQ;
+    suite.run("ec", "keyGen", at, [&] { crypto.keyGen(G, q, kp, kQ); });
+    suite.run("ec", "keyGen(FixedBaseTable)", at, [&] { crypto.keyGen(T, kp, kQ); });
+    suite.run("ec", "ecdhSharedSecret", at, [&] { crypto.ecdhSharedSecret(priv, Q2); });
+
+    ECPoint M = crypto.fixedBaseMultiply(T, threadDRBG().randomRange(ZZ(1), q - 1));
+    pair<ECPoint, ECPoint> C = crypto.elgamalEncryptEC(M, T, Q);
+    suite.run("ec", "elgamalEncryptEC", at, [&] { crypto.elgamalEncryptEC(M, G, Q, q); });
+    suite.run("ec", "elgamalEncryptEC(FixedBaseTable)", at, [&] { crypto.elgamalEncryptEC(M, T, Q); });
+    suite.run("ec", "elgamalDecryptEC", at, [&] { crypto.elgamalDecryptEC(C, priv); });
+
+    ZZ msg = threadDRBG().randomBnd(q);
+    pair<ZZ,ZZ> sig = crypto.signECDSA(msg, priv, T);
+    suite.run("ec", "signECDSA", at, [&] { crypto.signECDSA(msg, priv, G, q); });
+    suite.run("ec", "signECDSA(FixedBaseTable)", at, [&] { crypto.signECDSA(msg, priv, T); });
+    suite.run("ec", "verifyECDSA", at, [&] { crypto.verifyECDSA(msg, sig, G, Q, q); });
+    crypto.enableKeyCache(4, 1);
+    suite.run("ec", "verifyECDSA(key cache)", with("w", 4), [&] { crypto.verifyECDSA(msg, sig, G, Q, q); });
+    crypto.disableKeyCache();
+    if (crypto.glvInUse()) {
+        crypto.useGLV(false);
+        suite.run("ec", "scalarMultiplyInto(no GLV)", with("w", w), [&] { crypto.scalarMultiplyInto(out, Q, k); });
+        suite.run("ec", "verifyECDSA(no GLV)", at, [&] { crypto.verifyECDSA(msg, sig, G, Q, q); });
+        crypto.useGLV(true);
+    }
+
+    const size_t batch = 64;
+    vector<ECDSAVerifyItem> items(batch);
+    vector<ZZ> msgs(batch);
+    vector<ECPoint> pts(batch);
+    for (size_t i = 0; i < batch; i++) {
+        msgs[i] = threadDRBG().randomBnd(q);
+        items[i].msg = msgs[i];
+        items[i].sig = crypto.signECDSA(msgs[i], priv, T);
+        items[i].Q = Q;
+        pts[i] = crypto.fixedBaseMultiply(T, threadDRBG().randomRange(ZZ(1), q - 1));
+    }
+    vector<Param> batchAt = with("batch", batch);
+    suite.run("ec", "verifyECDSABatch", batchAt, [&] { crypto.verifyECDSABatch(items, G, q); });
+    suite.run("ec", "signECDSAParallel", batchAt, [&] { crypto.signECDSAParallel(msgs, priv, G, q); });
+    suite.run("ec", "signECDSAParallel(FixedBaseTable)", batchAt, [&] { crypto.signECDSAParallel(msgs, priv, T); });
+    suite.run("ec", "verifyECDSAParallel", batchAt, [&] { crypto.verifyECDSAParallel(items, G, q); });
+    suite.run("ec", "elgamalEncryptECParallel", batchAt, [&] { crypto.elgamalEncryptECParallel(pts, G, Q, q); });
+
+    string doc = randomText(1024);
+    MessageSource src = MessageSource::buffer(doc.data(), doc.size());
+    vector<Param> streamAt = with("message_bytes", doc.size());
+    pair<ZZ,ZZ> docSig = crypto.signECDSAStream(src, priv, T);
+    suite.run("ec", "signECDSAStream", streamAt, [&] { crypto.signECDSAStream(src, priv, G, q); });
+    suite.run("ec", "signECDSAStream(FixedBaseTable)", streamAt, [&] { crypto.signECDSAStream(src, priv, T); });
+    suite.run("ec", "verifyECDSAStream", streamAt, [&] { crypto.verifyECDSAStream(src, docSig, G, Q, q); });
+
+    for (bool compressed : { true, false }) {
+        vector<Param> wireAt = at;
+        wireAt.push_back(Param("compressed", compressed ? "true" : "false"));
+        vector<unsigned char> one(crypto.pointBytes(compressed)), all(batch * one.size()), ct(2 * one.size());
+        crypto.encodePoint(Q, one.data(), compressed);
+        crypto.encodePoints(pts.data(), batch, all.data(), compressed);
+        crypto.encodeCiphertext(C, ct.data(), compressed);
+        vector<ECPoint> decoded(batch);
+        suite.run("ec", "encodePoint", wireAt, [&] { crypto.encodePoint(Q, one.data(), compressed); });
+        suite.run("ec", "decodePoint", wireAt, [&] { crypto.decodePoint(one.data(), compressed); });
+        wireAt.push_back(num("batch", batch));
+        suite.run("ec", "encodePoints", wireAt, [&] { crypto.encodePoints(pts.data(), batch, all.data(), compressed); });
+        suite.run("ec", "decodePoints", wireAt, [&] { crypto.decodePoints(all.data(), batch, decoded.data(), compressed); });
+        wireAt.pop_back();
+        suite.run("ec", "encodeCiphertext", wireAt, [&] { crypto.encodeCiphertext(C, ct.data(), compressed); });
+        suite.run("ec", "decodeCiphertext", wireAt, [&] { crypto.decodeCiphertext(ct.data(), compressed); });
+    }
+}
+
+void benchEC(Suite& suite, appliedCryptography& crypto) {
+    ZZ p256 = conv<ZZ>(P256_P), k256 = conv<ZZ>(K256_P);
+    const CurveCase cases[] = {
+        // the demo curve from main.cpp: y^2 = x^3 + x + 6 mod 11, G = (2, 7) of order 13
+        { "demo-11", ZZ(11), ZZ(13), ZZ(1), ZZ(6), ZZ(2), ZZ(7), false },
+        { "P-256", p256, conv<ZZ>(P256_N), p256 - 3, conv<ZZ>(P256_B), conv<ZZ>(P256_GX), conv<ZZ>(P256_GY), true },
+        { "P-256", p256, conv<ZZ>(P256_N), p256 - 3, conv<ZZ>(P256_B), conv<ZZ>(P256_GX), conv<ZZ>(P256_GY), false },
+        { "secp256k1", k256, conv<ZZ>(K256_N), ZZ(0), ZZ(7), conv<ZZ>(K256_GX), conv<ZZ>(K256_GY), true },
+        { "secp256k1", k256, conv<ZZ>(K256_N), ZZ(0), ZZ(7), conv<ZZ>(K256_GX), conv<ZZ>(K256_GY), false },
+    };
+    for (const CurveCase& c : cases) benchCurve(suite, crypto, c);
+}
+
+int usage() {
+    cerr << "usage: crypto_bench [--seconds S] [--out FILE] [classical] [otp] [dh] [elgamal] [ec]" << endl;
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    double seconds = 0.2;
+    string outPath;
+    vector<string> groups;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+            if (seconds <= 0) return usage();
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (argv[i][0] == '-') {
+            return usage();
+        } else {
+            groups.push_back(argv[i]);
+        }
+    }
+    for (const string& g : groups) {
+        if (g != "classical" && g != "otp" && g != "dh" && g != "elgamal" && g != "ec") return usage();
+    }
+
+    Suite suite(seconds, groups);
+    appliedCryptography crypto;
+    try {
+        if (suite.wants("classical")) benchClassical(suite, crypto);
+        if (suite.wants("otp")) benchOTP(suite, crypto);
+        if (suite.wants("dh")) benchDH(suite, crypto);
+        if (suite.wants("elgamal")) benchElGamal(suite, crypto);
+        if (suite.wants("ec")) benchEC(suite, crypto);
+    } catch (const exception& e) {
+        cerr << "crypto_bench: " << e.what() << endl;
+        return 1;
+    }
+
+    if (outPath.empty()) {
+        suite.writeJSON(cout);
+        return 0;
+    }
+    ofstream out(outPath);
+    suite.writeJSON(out);
+    if (!out) {
+        cerr << "crypto_bench: could not write " << outPath << endl;
+        return 1;
+    }
+    return 0;
+}
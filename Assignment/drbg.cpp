@@ -0,0 +1,230 @@
+#include "drbg.hpp"
+#include "instrument.hpp"
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <NTL/ZZ_limbs.h>
+#if defined(__linux__)
+#include <sys/random.h>
+#endif
+#if defined(__unix__)
+#include <pthread.h>
+#endif
+
+using namespace NTL;
+
+typedef uint32_t v8u __attribute__((vector_size(32)));
+
+// a macro rather than a function: v8u arguments would change ABI between the generic and AVX2 builds
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define QR(a, b, c, d) \
+    a += b; d ^= a; d = ROTL(d, 16); \
+    c += d; b ^= c; b = ROTL(b, 12); \
+    a += b; d ^= a; d = ROTL(d, 8);  \
+    c += d; b ^= c; b = ROTL(b, 7);
+
+// Eight ChaCha20 blocks at counters ctr..ctr+7, one block per vector lane
+static inline __attribute__((always_inline))
+void chachaCore8(const uint32_t key[8], const uint32_t nonce[3], uint32_t ctr, unsigned char* out) {
+    v8u s[16];
+    s[0] = v8u{} + 0x61707865u;
+    s[1] = v8u{} + 0x3320646eu;
+    s[2] = v8u{} + 0x79622d32u;
+    s[3] = v8u{} + 0x6b206574u;
+    for (int i = 0; i < 8; i++) s[4 + i] = v8u{} + key[i];
+    s[12] = v8u{ ctr, ctr + 1, ctr + 2, ctr + 3, ctr + 4, ctr + 5, ctr + 6, ctr + 7 };
+    for (int i = 0; i < 3; i++) s[13 + i] = v8u{} + nonce[i];
+
+    v8u x[16];
+    for (int i = 0; i < 16; i++) x[i] = s[i];
+    for (int round = 0; round < 10; round++) {
+        QR(x[0], x[4], x[8],  x[12]);
+        QR(x[1], x[5], x[9],  x[13]);
+        QR(x[2], x[6], x[10], x[14]);
+        QR(x[3], x[7], x[11], x[15]);
+        QR(x[0], x[5], x[10], x[15]);
+        QR(x[1], x[6], x[11], x[12]);
+        QR(x[2], x[7], x[8],  x[13]);
+        QR(x[3], x[4], x[9],  x[14]);
+    }
+    for (int i = 0; i < 16; i++) x[i] += s[i];
+
+    // lane b of word i is word i of block b (little-endian words)
+    for (int b = 0; b < 8; b++) {
+        for (int i = 0; i < 16; i++) {
+            uint32_t w = x[i][b];
+            memcpy(out + 64 * b + 4 * i, &w, 4);
+        }
+    }
+}
+
+#undef QR
+#undef ROTL
+
+static void chachaGeneric(const uint32_t key[8], const uint32_t nonce[3], uint32_t ctr, unsigned char* out) {
+    chachaCore8(key, nonce, ctr, out);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void chachaAVX2(const uint32_t key[8], const uint32_t nonce[3], uint32_t ctr, unsigned char* out) {
+    chachaCore8(key, nonce, ctr, out);
+}
+#endif
+
+typedef void (*ChaChaKernel)(const uint32_t*, const uint32_t*, uint32_t, unsigned char*);
+
+struct ChaChaDispatch {
+    ChaChaKernel fn;
+    const char* name;
+};
+
+static const ChaChaDispatch& chachaDispatch() {
+    static const ChaChaDispatch d = [] {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return ChaChaDispatch{ chachaAVX2, "avx2" };
+#endif
+        return ChaChaDispatch{ chachaGeneric, "generic" };
+    }();
+    return d;
+}
+
+const char* ChaChaDRBG::kernelName() {
+    return chachaDispatch().name;
+}
+
+// 32 bytes of OS entropy
+static void osSeed(unsigned char seed[32]) {
+#if defined(__linux__)
+    size_t got = 0;
+    while (got < 32) {
+        ssize_t r = getrandom(seed + got, 32 - got, 0);
+        if (r <= 0) break;
+        got += r;
+    }
+    if (got == 32) return;
+#endif
+    std::random_device rd;
+    for (int i = 0; i < 32; i += 4) {
+        uint32_t w = rd();
+        memcpy(seed + i, &w, 4);
+    }
+}
+
+// Bumped in the child after every fork(); a thread_local generator copied into the child sees it
+// change and reseeds, so parent and child never share a stream
+static std::atomic<unsigned long> forkCount{ 0 };
+
+static void watchForks() {
+#if defined(__unix__)
+    static const bool registered = pthread_atfork(nullptr, nullptr, [] {
+        forkCount.fetch_add(1, std::memory_order_relaxed);
+    }) == 0;
+    (void)registered;
+#endif
+}
+
+ChaChaDRBG::ChaChaDRBG() {
+    watchForks();
+    reseed();
+}
+
+void ChaChaDRBG::reseed() {
+    unsigned char seed[32];
+    forkGeneration = forkCount.load(std::memory_order_relaxed);
+    osSeed(seed);
+    init(seed);
+    memset(seed, 0, sizeof(seed));
+    memset(buf, 0, sizeof(buf));
+    osSeeded = true;
+}
+
+ChaChaDRBG::ChaChaDRBG(const unsigned char seed[32]) {
+    init(seed);
+}
+
+void ChaChaDRBG::init(const unsigned char seed[32]) {
+    memcpy(key, seed, 32);
+    nonce[0] = nonce[1] = nonce[2] = 0;
+    counter = 0;
+    pos = BUF_BYTES;
+}
+
+void ChaChaDRBG::generate(unsigned char* out) {
+    chachaDispatch().fn(key, nonce, counter, out);
+    counter += BLOCKS;
+    if (counter == 0) {             // 2^32 blocks used under this nonce, move to the next one
+        if (++nonce[0] == 0 && ++nonce[1] == 0) ++nonce[2];
+    }
+}
+
+void ChaChaDRBG::refill() {
+    generate(buf);
+    memcpy(key, buf, KEY_BYTES);
+    memset(buf, 0, KEY_BYTES);
+    pos = KEY_BYTES;
+}
+
+// Every byte goes through the buffer, so the stream doesn't depend on how requests are split
+void ChaChaDRBG::fill(unsigned char* out, size_t n) {
+    if (osSeeded && forkGeneration != forkCount.load(std::memory_order_relaxed)) reseed();
+    while (n > 0) {
+        if (pos == BUF_BYTES) refill();
+        size_t take = std::min(n, BUF_BYTES - pos);
+        memcpy(out, buf + pos, take);
+        memset(buf + pos, 0, take);
+        pos += take;
+        out += take;
+        n -= take;
+    }
+}
+
+uint64_t ChaChaDRBG::next64() {
+    uint64_t r;
+    fill((unsigned char*)&r, sizeof(r));
+    return r;
+}
+
+// Rejection sampling on NumBits(n - 1) bits, fewer than 2 draws on average
+ZZ ChaChaDRBG::randomBnd(const ZZ& n) {
+    if (n <= 1) return ZZ(0);
+    long bits = NumBits(n - 1);
+    long bytes = (bits + 7) / 8;
+    unsigned char tmp[512];
+    unsigned char* p = bytes <= (long)sizeof(tmp) ? tmp : new unsigned char[bytes];
+
+    ZZ r;
+    for (;;) {
+        fill(p, bytes);
+        if (bits % 8) p[bytes - 1] &= (unsigned char)((1 << (bits % 8)) - 1);
+        ZZFromBytes(r, p, bytes);
+        if (r < n) break;
+        CRYPTO_COUNT(CTR_RNG_REJECT);
+    }
+
+    memset(p, 0, bytes);
+    if (p != tmp) delete[] p;
+    return r;
+}
+
+ZZ ChaChaDRBG::randomRange(const ZZ& lo, const ZZ& hi) {
+    if (hi < lo) throw std::runtime_error("randomRange: empty range");
+    return lo + randomBnd(hi - lo + 1);
+}
+
+ChaChaDRBG& threadDRBG() {
+    thread_local ChaChaDRBG drbg;
+    return drbg;
+}
+
+void zeroize(ZZ& x) {
+    long n = x.size();
+    if (n > 0) {
+        volatile ZZ_limb_t* p = const_cast<ZZ_limb_t*>(ZZ_limbs_get(x));
+        for (long i = 0; i < n; i++) p[i] = 0;
+    }
+    clear(x);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <NTL/ZZ.h>
+
+// ChaCha20 keystream generator used for every key, nonce and ephemeral value in appliedCryptography.
+// Refills 8 blocks (512 bytes) at a time with a vectorized block function. Fast key erasure: the
+// first 32 bytes of every refill become the next key, and bytes are wiped from the buffer as they are
+// served, so a later copy of the state cannot recompute earlier output. OS-seeded generators reseed
+// from the OS in a child process after fork(). Not thread-safe: use threadDRBG().
+class ChaChaDRBG {
+public:
+    ChaChaDRBG();                                   // seeded from the OS
+    ChaChaDRBG(const unsigned char seed[32]);       // deterministic, for tests and benchmarks
+
+    void fill(unsigned char* out, size_t n);
+    uint64_t next64();
+    NTL::ZZ randomBnd(const NTL::ZZ& n);            // uniform in [0, n), 0 if n <= 1
+    NTL::ZZ randomRange(const NTL::ZZ& lo, const NTL::ZZ& hi);  // uniform in [lo, hi]
+
+    static const char* kernelName();                // "avx2" or "generic"
+
+private:
+    static const size_t BLOCKS = 8;
+    static const size_t BUF_BYTES = 64 * BLOCKS;
+
+    static const size_t KEY_BYTES = 32;
+
+    uint32_t key[8];
+    uint32_t nonce[3];
+    uint32_t counter;
+    unsigned char buf[BUF_BYTES];
+    size_t pos;                                     // next unused byte of buf
+    bool osSeeded = false;
+    unsigned long forkGeneration = 0;               // forks seen when last seeded from the OS
+
+    void init(const unsigned char seed[32]);
+    void reseed();                                  // fresh OS seed, buffered bytes dropped
+    void generate(unsigned char* out);              // next BUF_BYTES of keystream
+    void refill();                                  // new buffer, its first KEY_BYTES rekey
+};
+
+// The calling thread's generator, created and OS-seeded on first use
+ChaChaDRBG& threadDRBG();
+
+// Overwrite the limbs of a secret and set it to 0, so the value doesn't linger in freed memory
+void zeroize(NTL::ZZ& x);
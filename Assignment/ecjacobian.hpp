@@ -0,0 +1,680 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include "instrument.hpp"
+
+// Elliptic curve point arithmetic on y^2 = x^3 + a x + b, templated on the field type F.
+// F needs +, -, *, unary -, sqr(F), inv(F), IsZero(F), == and F(1); NTL's ZZ_p and Fp256 both qualify.
+// The *Into variants use NTL's procedural forms (add, sub, mul, sqr, negate, inv, clear, set) on
+// caller-owned registers instead, so a warmed-up heap-backed F (ZZ_p) stops allocating.
+// Each formula reports its field operation count to instrument.hpp next to the code that does the work.
+
+
+// Affine point, isInfinity marks the point at infinity
+// Movable: moving hands the coordinates' limbs over instead of copying them.
+template<class F>
+struct AffinePoint {
+    F x, y;
+    bool isInfinity;
+    AffinePoint() : isInfinity(true) {}
+    AffinePoint(F _x, F _y) : x(std::move(_x)), y(std::move(_y)), isInfinity(false) {}
+    AffinePoint(const AffinePoint&) = default;
+    AffinePoint(AffinePoint&&) = default;
+    AffinePoint& operator=(const AffinePoint&) = default;
+    AffinePoint& operator=(AffinePoint&&) = default;
+};
+
+
+// Jacobian point (X : Y : Z) = affine (X/Z^2, Y/Z^3), Z == 0 is the point at infinity
+template<class F>
+struct JacobianPoint {
+    F X, Y, Z;
+    JacobianPoint() {}
+    JacobianPoint(F _X, F _Y, F _Z) : X(std::move(_X)), Y(std::move(_Y)), Z(std::move(_Z)) {}
+    bool isInfinity() const { return IsZero(Z); }
+};
+
+
+template<class F>
+JacobianPoint<F> ecToJacobian(const AffinePoint<F>& P) {
+    if (P.isInfinity) return JacobianPoint<F>();
+    return JacobianPoint<F>(P.x, P.y, F(1));
+}
+
+template<class F>
+AffinePoint<F> ecNeg(const AffinePoint<F>& P) {
+    if (P.isInfinity) return P;
+    return AffinePoint<F>(P.x, -P.y);
+}
+
+// Jacobian -> affine, one inversion
+template<class F>
+AffinePoint<F> ecToAffine(const JacobianPoint<F>& P) {
+    if (P.isInfinity()) return AffinePoint<F>();
+    CRYPTO_COUNT(CTR_FIELD_INV);
+    CRYPTO_COUNT(CTR_FIELD_SQR);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 3);
+    F zInv = inv(P.Z);
+    F zInv2 = sqr(zInv);
+    return AffinePoint<F>(P.X * zInv2, P.Y * zInv2 * zInv);
+}
+
+// Normalize many Jacobian points with one inversion (Montgomery's trick)
+template<class F>
+std::vector<AffinePoint<F>> ecNormalizeBatch(const std::vector<JacobianPoint<F>>& pts) {
+    size_t n = pts.size();
+    std::vector<AffinePoint<F>> out(n);
+
+    // prefix[i] = product of the nonzero Z's before i
+    std::vector<F> prefix(n);
+    F acc(1);
+    for (size_t i = 0; i < n; i++) {
+        prefix[i] = acc;
+        if (!pts[i].isInfinity()) {
+            acc = acc * pts[i].Z;
+            CRYPTO_COUNT(CTR_FIELD_MUL);
+        }
+    }
+
+    F accInv = inv(acc);
+    CRYPTO_COUNT(CTR_FIELD_INV);
+    for (size_t i = n; i-- > 0; ) {
+        if (pts[i].isInfinity()) continue;
+        CRYPTO_COUNT_N(CTR_FIELD_MUL, 5);
+        CRYPTO_COUNT(CTR_FIELD_SQR);
+        F zInv = accInv * prefix[i];        // 1/Z_i
+        accInv = accInv * pts[i].Z;
+        F zInv2 = sqr(zInv);
+        out[i] = AffinePoint<F>(pts[i].X * zInv2, pts[i].Y * zInv2 * zInv);
+    }
+    return out;
+}
+
+// Jacobian doubling (dbl-2007-bl style, works for any a)
+template<class F>
+JacobianPoint<F> ecDouble(const JacobianPoint<F>& P, const F& a) {
+    if (P.isInfinity() || IsZero(P.Y)) return JacobianPoint<F>();
+    CRYPTO_COUNT(CTR_POINT_DOUBLE);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 4);
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 6);
+
+    F XX = sqr(P.X);
+    F YY = sqr(P.Y);
+    F ZZ2 = sqr(P.Z);
+    F S = P.X * YY;
+    S = S + S;
+    S = S + S;                              // S = 4*X*Y^2
+    F M = XX + XX + XX + a * sqr(ZZ2);      // M = 3*X^2 + a*Z^4
+    F Y8 = sqr(YY);
+    Y8 = Y8 + Y8;
+    Y8 = Y8 + Y8;
+    Y8 = Y8 + Y8;                           // 8*Y^4
+
+    F X3 = sqr(M) - S - S;
+    F Y3 = M * (S - X3) - Y8;
+    F Z3 = P.Y * P.Z;
+    return JacobianPoint<F>(X3, Y3, Z3 + Z3);
+}
+
+// Jacobian + Jacobian
+template<class F>
+JacobianPoint<F> ecAdd(const JacobianPoint<F>& P, const JacobianPoint<F>& Q, const F& a) {
+    if (P.isInfinity()) return Q;
+    if (Q.isInfinity()) return P;
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 6);
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 2);
+
+    F Z1Z1 = sqr(P.Z);
+    F Z2Z2 = sqr(Q.Z);
+    F U1 = P.X * Z2Z2;
+    F U2 = Q.X * Z1Z1;
+    F S1 = P.Y * Q.Z * Z2Z2;
+    F S2 = Q.Y * P.Z * Z1Z1;
+
+    F H = U2 - U1;
+    F r = S2 - S1;
+    if (IsZero(H)) {
+        if (IsZero(r)) return ecDouble(P, a);  // P == Q
+        return JacobianPoint<F>();              // P == -Q
+    }
+    CRYPTO_COUNT(CTR_POINT_ADD);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 6);
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 2);
+
+    F HH = sqr(H);
+    F HHH = H * HH;
+    F V = U1 * HH;
+
+    F X3 = sqr(r) - HHH - V - V;
+    F Y3 = r * (V - X3) - S1 * HHH;
+    F Z3 = P.Z * Q.Z * H;
+    return JacobianPoint<F>(X3, Y3, Z3);
+}
+
+// Jacobian + affine (mixed addition, Q has Z = 1)
+template<class F>
+JacobianPoint<F> ecAddMixed(const JacobianPoint<F>& P, const AffinePoint<F>& Q, const F& a) {
+    if (Q.isInfinity) return P;
+    if (P.isInfinity()) return ecToJacobian(Q);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 3);
+    CRYPTO_COUNT(CTR_FIELD_SQR);
+
+    F Z1Z1 = sqr(P.Z);
+    F U2 = Q.x * Z1Z1;
+    F S2 = Q.y * P.Z * Z1Z1;
+
+    F H = U2 - P.X;
+    F r = S2 - P.Y;
+    if (IsZero(H)) {
+        if (IsZero(r)) return ecDouble(P, a);
+        return JacobianPoint<F>();
+    }
+    CRYPTO_COUNT(CTR_POINT_ADD);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 5);
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 2);
+
+    F HH = sqr(H);
+    F HHH = H * HH;
+    F V = P.X * HH;
+
+    F X3 = sqr(r) - HHH - V - V;
+    F Y3 = r * (V - X3) - P.Y * HHH;
+    F Z3 = P.Z * H;
+    return JacobianPoint<F>(X3, Y3, Z3);
+}
+
+// Affine table P, 3P, 5P, ..., (2^(w-1) - 1)P
+template<class F>
+std::vector<AffinePoint<F>> ecOddMultiples(const AffinePoint<F>& P, long w, const F& a) {
+    long count = 1L << (w - 2);
+    std::vector<JacobianPoint<F>> jac(count);
+    jac[0] = ecToJacobian(P);
+    if (count > 1) {
+        JacobianPoint<F> P2 = ecDouble(jac[0], a);
+        for (long i = 1; i < count; i++) {
+            jac[i] = ecAdd(jac[i - 1], P2, a);
+        }
+    }
+    return ecNormalizeBatch(jac);
+}
+
+// R = R + d*P for a wNAF digit d, using the odd-multiples table of P
+template<class F>
+void ecAddDigit(JacobianPoint<F>& R, const std::vector<AffinePoint<F>>& table, long d, const F& a) {
+    if (d > 0) R = ecAddMixed(R, table[d / 2], a);
+    else if (d < 0) R = ecAddMixed(R, ecNeg(table[-d / 2]), a);
+}
+
+// sum naf[i] 2^i P, MSB-first; the first digit is loaded rather than added to a doubled infinity
+template<class F>
+JacobianPoint<F> ecWnafMultiply(const AffinePoint<F>& P, const std::vector<long>& naf, long w, const F& a) {
+    std::vector<AffinePoint<F>> table = ecOddMultiples(P, w, a);
+
+    JacobianPoint<F> R;
+    for (size_t i = naf.size(); i-- > 0; ) {
+        if (!R.isInfinity()) R = ecDouble(R, a);
+        ecAddDigit(R, table, naf[i], a);
+    }
+    return R;
+}
+
+// In-place formulas. Outputs may alias inputs; every temporary lives in an ECScratch.
+
+template<class F>
+struct ECScratch {
+    F A, B, C, D, E, H, R, S, T, U, V, W;
+};
+
+// R = 2P, same formula as ecDouble
+template<class F>
+void ecDoubleInto(JacobianPoint<F>& R, const JacobianPoint<F>& P, const F& a, ECScratch<F>& s) {
+    if (P.isInfinity() || IsZero(P.Y)) {
+        clear(R.Z);
+        return;
+    }
+    CRYPTO_COUNT(CTR_POINT_DOUBLE);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 4);
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 6);
+    sqr(s.A, P.X);
+    sqr(s.B, P.Y);
+    sqr(s.C, P.Z);
+    mul(s.S, P.X, s.B);
+    add(s.S, s.S, s.S);
+    add(s.S, s.S, s.S);                     // S = 4*X*Y^2
+    sqr(s.C, s.C);
+    mul(s.C, s.C, a);
+    add(s.D, s.A, s.A);
+    add(s.D, s.D, s.A);
+    add(s.D, s.D, s.C);                     // M = 3*X^2 + a*Z^4
+    sqr(s.B, s.B);
+    add(s.B, s.B, s.B);
+    add(s.B, s.B, s.B);
+    add(s.B, s.B, s.B);                     // 8*Y^4
+    mul(s.E, P.Y, P.Z);
+
+    sqr(R.X, s.D);
+    sub(R.X, R.X, s.S);
+    sub(R.X, R.X, s.S);
+    sub(s.T, s.S, R.X);
+    mul(s.T, s.D, s.T);
+    sub(R.Y, s.T, s.B);
+    add(R.Z, s.E, s.E);
+}
+
+// R = P + Q, same formula as ecAdd
+template<class F>
+void ecAddInto(JacobianPoint<F>& R, const JacobianPoint<F>& P, const JacobianPoint<F>& Q, const F& a, ECScratch<F>& s) {
+    if (P.isInfinity()) {
+        if (&R != &Q) R = Q;
+        return;
+    }
+    if (Q.isInfinity()) {
+        if (&R != &P) R = P;
+        return;
+    }
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 6);
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 2);
+    sqr(s.A, P.Z);
+    sqr(s.B, Q.Z);
+    mul(s.C, P.X, s.B);                     // U1
+    mul(s.D, Q.X, s.A);                     // U2
+    mul(s.E, P.Y, Q.Z);
+    mul(s.E, s.E, s.B);                     // S1
+    mul(s.S, Q.Y, P.Z);
+    mul(s.S, s.S, s.A);                     // S2
+    sub(s.H, s.D, s.C);
+    sub(s.R, s.S, s.E);
+    if (IsZero(s.H)) {
+        if (IsZero(s.R)) ecDoubleInto(R, P, a, s);
+        else clear(R.Z);
+        return;
+    }
+    CRYPTO_COUNT(CTR_POINT_ADD);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 6);
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 2);
+    sqr(s.T, s.H);                          // HH
+    mul(s.U, s.H, s.T);                     // HHH
+    mul(s.V, s.C, s.T);                     // V
+    mul(s.W, P.Z, Q.Z);
+    mul(R.Z, s.W, s.H);
+    sqr(R.X, s.R);
+    sub(R.X, R.X, s.U);
+    sub(R.X, R.X, s.V);
+    sub(R.X, R.X, s.V);
+    sub(s.W, s.V, R.X);
+    mul(s.W, s.R, s.W);
+    mul(s.E, s.E, s.U);
+    sub(R.Y, s.W, s.E);
+}
+
+// R = P + Q for affine Q, or P - Q when negQ; same formula as ecAddMixed
+template<class F>
+void ecAddMixedInto(JacobianPoint<F>& R, const JacobianPoint<F>& P, const AffinePoint<F>& Q, bool negQ, const F& a, ECScratch<F>& s) {
+    if (Q.isInfinity) {
+        if (&R != &P) R = P;
+        return;
+    }
+    if (P.isInfinity()) {
+        R.X = Q.x;
+        if (negQ) negate(R.Y, Q.y);
+        else R.Y = Q.y;
+        set(R.Z);
+        return;
+    }
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 3);
+    CRYPTO_COUNT(CTR_FIELD_SQR);
+    sqr(s.A, P.Z);
+    mul(s.B, Q.x, s.A);                     // U2
+    mul(s.C, Q.y, P.Z);
+    mul(s.C, s.C, s.A);                     // S2
+    if (negQ) negate(s.C, s.C);
+    sub(s.H, s.B, P.X);
+    sub(s.R, s.C, P.Y);
+    if (IsZero(s.H)) {
+        if (IsZero(s.R)) ecDoubleInto(R, P, a, s);
+        else clear(R.Z);
+        return;
+    }
+    CRYPTO_COUNT(CTR_POINT_ADD);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 5);
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 2);
+    sqr(s.D, s.H);                          // HH
+    mul(s.E, s.H, s.D);                     // HHH
+    mul(s.T, P.X, s.D);                     // V
+    mul(s.U, P.Y, s.E);
+    mul(R.Z, P.Z, s.H);
+    sqr(R.X, s.R);
+    sub(R.X, R.X, s.E);
+    sub(R.X, R.X, s.T);
+    sub(R.X, R.X, s.T);
+    sub(s.S, s.T, R.X);
+    mul(s.S, s.R, s.S);
+    sub(R.Y, s.S, s.U);
+}
+
+template<class F>
+void ecToAffineInto(AffinePoint<F>& R, const JacobianPoint<F>& P, ECScratch<F>& s) {
+    if (P.isInfinity()) {
+        R.isInfinity = true;
+        return;
+    }
+    CRYPTO_COUNT(CTR_FIELD_INV);
+    CRYPTO_COUNT(CTR_FIELD_SQR);
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 3);
+    inv(s.A, P.Z);
+    sqr(s.B, s.A);
+    mul(R.x, P.X, s.B);
+    mul(s.B, s.B, s.A);
+    mul(R.y, P.Y, s.B);
+    R.isInfinity = false;
+}
+
+// Working storage for the in-place wNAF path. Vectors only grow and the field registers keep their
+// limbs, so after the first call of a given size nothing is allocated.
+template<class F>
+struct ECArena {
+    ECScratch<F> s;
+    JacobianPoint<F> P2;
+    std::vector<JacobianPoint<F>> jac;
+    std::vector<AffinePoint<F>> table;
+    std::vector<AffinePoint<F>> table2;     // endomorphism images of table (GLV)
+    std::vector<F> prefix;
+    F X0, Y0, X1, Y1;                       // co-Z ladder R0, R1 (their shared Z is never computed)
+};
+
+// (a, b) = (b, a) when c = 1. Fp256 has a masked overload; for other fields (ZZ_p) this swaps the
+// limb pointers behind a branch.
+template<class F>
+void condSwap(F& a, F& b, uint64_t c) {
+    using std::swap;
+    if (c) swap(a, b);
+}
+
+template<class F>
+ECArena<F>& ecThreadArena() {
+    thread_local ECArena<F> arena;
+    return arena;
+}
+
+// arena.table[0 .. 2^(w-2)) = P, 3P, 5P, ... in affine form (one inversion), as ecOddMultiples
+template<class F>
+void ecOddMultiplesInto(const AffinePoint<F>& P, long w, const F& a, ECArena<F>& A) {
+    size_t count = size_t(1) << (w - 2);
+    if (A.jac.size() < count) A.jac.resize(count);
+    if (A.table.size() < count) A.table.resize(count);
+    if (A.prefix.size() < count) A.prefix.resize(count);
+
+    A.jac[0].X = P.x;
+    A.jac[0].Y = P.y;
+    set(A.jac[0].Z);
+    if (count > 1) {
+        ecDoubleInto(A.P2, A.jac[0], a, A.s);
+        for (size_t i = 1; i < count; i++) ecAddInto(A.jac[i], A.jac[i - 1], A.P2, a, A.s);
+    }
+
+    // Montgomery's trick over the nonzero Z's
+    F& acc = A.s.V;
+    set(acc);
+    for (size_t i = 0; i < count; i++) {
+        A.prefix[i] = acc;
+        if (!A.jac[i].isInfinity()) {
+            mul(acc, acc, A.jac[i].Z);
+            CRYPTO_COUNT(CTR_FIELD_MUL);
+        }
+    }
+    inv(acc, acc);
+    CRYPTO_COUNT(CTR_FIELD_INV);
+    for (size_t i = count; i-- > 0; ) {
+        if (A.jac[i].isInfinity()) {
+            A.table[i].isInfinity = true;
+            continue;
+        }
+        CRYPTO_COUNT_N(CTR_FIELD_MUL, 5);
+        CRYPTO_COUNT(CTR_FIELD_SQR);
+        mul(A.s.W, acc, A.prefix[i]);       // 1/Z_i
+        mul(acc, acc, A.jac[i].Z);
+        sqr(A.s.A, A.s.W);
+        mul(A.table[i].x, A.jac[i].X, A.s.A);
+        mul(A.s.A, A.s.A, A.s.W);
+        mul(A.table[i].y, A.jac[i].Y, A.s.A);
+        A.table[i].isInfinity = false;
+    }
+}
+
+// R = R + d*P for a wNAF digit d, in place
+template<class F>
+void ecAddDigitInto(JacobianPoint<F>& R, const std::vector<AffinePoint<F>>& table, long d, const F& a, ECScratch<F>& s) {
+    if (d > 0) ecAddMixedInto(R, R, table[d / 2], false, a, s);
+    else if (d < 0) ecAddMixedInto(R, R, table[-d / 2], true, a, s);
+}
+
+// R = sum naf[i] 2^i P without allocating once A is warm; same digit schedule as ecWnafMultiply
+template<class F>
+void ecWnafMultiplyInto(JacobianPoint<F>& R, const AffinePoint<F>& P, const std::vector<long>& naf, long w,
+                        const F& a, ECArena<F>& A) {
+    ecOddMultiplesInto(P, w, a, A);
+    clear(R.Z);
+    for (size_t i = naf.size(); i-- > 0; ) {
+        if (!R.isInfinity()) ecDoubleInto(R, R, a, A.s);
+        ecAddDigitInto(R, A.table, naf[i], a, A.s);
+    }
+}
+
+// R = sum naf1[i] 2^i P + sum naf2[i] 2^i phi(P) in place, for the endomorphism phi(x, y) = (beta x, y)
+// of an a = 0 curve. phi's table is P's with each x multiplied by beta, so it costs no inversion.
+template<class F>
+void ecGlvMultiplyInto(JacobianPoint<F>& R, const AffinePoint<F>& P, const std::vector<long>& naf1,
+                       const std::vector<long>& naf2, long w, const F& a, const F& beta, ECArena<F>& A) {
+    ecOddMultiplesInto(P, w, a, A);
+    size_t count = size_t(1) << (w - 2);
+    if (A.table2.size() < count) A.table2.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        A.table2[i].isInfinity = A.table[i].isInfinity;
+        if (A.table[i].isInfinity) continue;
+        mul(A.table2[i].x, A.table[i].x, beta);
+        A.table2[i].y = A.table[i].y;
+        CRYPTO_COUNT(CTR_FIELD_MUL);
+    }
+
+    clear(R.Z);
+    for (size_t i = std::max(naf1.size(), naf2.size()); i-- > 0; ) {
+        if (!R.isInfinity()) ecDoubleInto(R, R, a, A.s);
+        if (i < naf1.size()) ecAddDigitInto(R, A.table, naf1[i], a, A.s);
+        if (i < naf2.size()) ecAddDigitInto(R, A.table2, naf2[i], a, A.s);
+    }
+}
+
+// Interleaved wNAF: a*P + b*Q with both digit strings sharing the doublings
+template<class F>
+JacobianPoint<F> ecWnafMultiply2(const AffinePoint<F>& P, const std::vector<long>& nafA,
+                                 const AffinePoint<F>& Q, const std::vector<long>& nafB, long w, const F& a) {
+    std::vector<AffinePoint<F>> tableA = ecOddMultiples(P, w, a);
+    std::vector<AffinePoint<F>> tableB = ecOddMultiples(Q, w, a);
+
+    JacobianPoint<F> R;
+    for (size_t i = std::max(nafA.size(), nafB.size()); i-- > 0; ) {
+        if (!R.isInfinity()) R = ecDouble(R, a);
+        if (i < nafA.size()) ecAddDigit(R, tableA, nafA[i], a);
+        if (i < nafB.size()) ecAddDigit(R, tableB, nafB[i], a);
+    }
+    return R;
+}
+
+// Table of phi(P), phi(3P), ... for phi(x, y) = (beta x, y), from the table of P
+template<class F>
+std::vector<AffinePoint<F>> ecEndomorphismTable(const std::vector<AffinePoint<F>>& table, const F& beta) {
+    std::vector<AffinePoint<F>> out(table.size());
+    for (size_t i = 0; i < table.size(); i++) {
+        if (table[i].isInfinity) continue;
+        out[i] = AffinePoint<F>(table[i].x * beta, table[i].y);
+        CRYPTO_COUNT(CTR_FIELD_MUL);
+    }
+    return out;
+}
+
+// Interleaved wNAF over any number of points: sum_j sum_i nafs[j][i] 2^i P_j, tables[j] the
+// odd-multiples table of P_j
+template<class F>
+JacobianPoint<F> ecWnafMultiplyMany(const std::vector<std::vector<AffinePoint<F>>>& tables,
+                                    const std::vector<std::vector<long>>& nafs, const F& a) {
+    size_t len = 0;
+    for (const std::vector<long>& naf : nafs) len = std::max(len, naf.size());
+
+    JacobianPoint<F> R;
+    for (size_t i = len; i-- > 0; ) {
+        if (!R.isInfinity()) R = ecDouble(R, a);
+        for (size_t j = 0; j < nafs.size(); j++) {
+            if (i < nafs[j].size()) ecAddDigit(R, tables[j], nafs[j][i], a);
+        }
+    }
+    return R;
+}
+
+// Fixed-base comb table, row-major: entry i * (2^w - 1) + j - 1 is j * 2^(w*i) * P for each of the
+// `windows` w-bit windows and j = 1 .. 2^w - 1, all normalized with one inversion
+template<class F>
+std::vector<AffinePoint<F>> ecCombTable(const AffinePoint<F>& P, long windows, long w, const F& a) {
+    long perRow = (1L << w) - 1;
+    std::vector<JacobianPoint<F>> jac;
+    jac.reserve(windows * perRow);
+    JacobianPoint<F> B = ecToJacobian(P);
+    for (long i = 0; i < windows; i++) {
+        JacobianPoint<F> acc = B;
+        jac.push_back(acc);
+        for (long j = 2; j <= perRow; j++) {
+            acc = ecAdd(acc, B, a);
+            jac.push_back(acc);
+        }
+        B = ecAdd(acc, B, a);               // 2^w * B_i
+    }
+    return ecNormalizeBatch(jac);
+}
+
+// sum digits[i] 2^(w*i) P from its comb table: one mixed addition per nonzero base-2^w digit
+// (least significant first, at most as many digits as the table has windows)
+template<class F>
+JacobianPoint<F> ecCombMultiply(const std::vector<AffinePoint<F>>& table, const std::vector<long>& digits, long w, const F& a) {
+    size_t perRow = (size_t(1) << w) - 1;
+    JacobianPoint<F> R;
+    for (size_t i = 0; i < digits.size(); i++) {
+        if (digits[i]) R = ecAddMixed(R, table[i * perRow + digits[i] - 1], a);
+    }
+    return R;
+}
+
+
+// Co-Z Montgomery ladder (Goundar, Joye, Miyaji, Rivain, Venelli), (X, Y)-only: R0 = mP and
+// R1 = (m+1)P share a Z that is never computed, and every key bit costs the same conjugate co-Z
+// addition plus co-Z update (9M + 5S) whatever its value, on the arena's registers. The register pair
+// that gets the sum is picked by condSwap on the key bit rather than by indexing with it. Z^2 is
+// recovered at the end from R1 - R0 = P, which costs one inversion. bits are MSB first with
+// bits[0] = 1. Sets x = x(kP) and returns true, or returns false when a co-Z sum degenerates (some
+// mP or (m+1)P hits the point at infinity) or x(P) = 0, in which case the caller takes the general path.
+template<class F>
+bool ecCoZLadderX(const AffinePoint<F>& P, const std::vector<char>& bits, const F& a, F& x, ECArena<F>& A) {
+    if (IsZero(P.x) || IsZero(P.y)) return false;
+    ECScratch<F>& s = A.s;
+
+    // DBLU: R1 = 2P and R0 = P, both on Z = 2y
+    CRYPTO_COUNT(CTR_POINT_DOUBLE);
+    CRYPTO_COUNT(CTR_FIELD_MUL);
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 5);
+    sqr(s.B, P.x);
+    sqr(s.E, P.y);
+    sqr(s.H, s.E);                          // L = y^4
+    add(s.S, P.x, s.E);
+    sqr(s.S, s.S);
+    sub(s.S, s.S, s.B);
+    sub(s.S, s.S, s.H);
+    add(s.S, s.S, s.S);                     // S = 4 x y^2
+    add(s.D, s.B, s.B);
+    add(s.D, s.D, s.B);
+    add(s.D, s.D, a);                       // M = 3 x^2 + a
+    add(s.H, s.H, s.H);
+    add(s.H, s.H, s.H);
+    add(s.H, s.H, s.H);                     // 8 y^4
+    sqr(A.X1, s.D);
+    sub(A.X1, A.X1, s.S);
+    sub(A.X1, A.X1, s.S);
+    sub(s.T, s.S, A.X1);
+    mul(s.T, s.D, s.T);
+    sub(A.Y1, s.T, s.H);
+    A.X0 = s.S;
+    A.Y0 = s.H;
+
+    // R_b sits in (X1, Y1) and R_(1-b) in (X0, Y0) while bit b is processed
+    bool degenerate = false;
+    uint64_t swapped = 0;
+    CRYPTO_COUNT_N(CTR_POINT_ADD, 2 * (bits.size() - 1));
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 9 * (bits.size() - 1));
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 5 * (bits.size() - 1));
+    for (size_t i = 1; i < bits.size(); i++) {
+        uint64_t b = (uint64_t)bits[i];
+        condSwap(A.X0, A.X1, swapped ^ (1 - b));
+        condSwap(A.Y0, A.Y1, swapped ^ (1 - b));
+        swapped = 1 - b;
+
+        // ZADDC: (R_(1-b), R_b) = (R_b + R_(1-b), R_b - R_(1-b))
+        sub(s.T, A.X1, A.X0);
+        degenerate |= IsZero(s.T);
+        sqr(s.C, s.T);
+        mul(s.U, A.X1, s.C);                // W1
+        mul(s.V, A.X0, s.C);                // W2
+        sub(s.T, s.U, s.V);
+        mul(s.A, A.Y1, s.T);                // A1
+        add(s.W, s.U, s.V);
+        sub(s.D, A.Y1, A.Y0);               // u
+        add(s.E, A.Y1, A.Y0);               // v
+        sqr(A.X0, s.D);
+        sub(A.X0, A.X0, s.W);
+        sub(s.T, s.U, A.X0);
+        mul(s.T, s.D, s.T);
+        sub(A.Y0, s.T, s.A);
+        sqr(A.X1, s.E);
+        sub(A.X1, A.X1, s.W);
+        sub(s.T, s.U, A.X1);
+        mul(s.T, s.E, s.T);
+        sub(A.Y1, s.T, s.A);
+
+        // ZADDU: (R_b, R_(1-b)) = (R_(1-b) + R_b, R_(1-b) on the new Z)
+        sub(s.T, A.X0, A.X1);
+        degenerate |= IsZero(s.T);
+        sqr(s.C, s.T);
+        mul(s.U, A.X0, s.C);                // W1
+        mul(s.V, A.X1, s.C);                // W2
+        sub(s.T, s.U, s.V);
+        mul(s.A, A.Y0, s.T);                // A1
+        sub(s.D, A.Y0, A.Y1);               // u
+        sqr(A.X1, s.D);
+        sub(A.X1, A.X1, s.U);
+        sub(A.X1, A.X1, s.V);
+        sub(s.T, s.U, A.X1);
+        mul(s.T, s.D, s.T);
+        sub(A.Y1, s.T, s.A);
+        A.X0 = s.U;
+        A.Y0 = s.A;
+    }
+    condSwap(A.X0, A.X1, swapped);
+    condSwap(A.Y0, A.Y1, swapped);
+
+    // R1 - R0 = P: its co-Z X over (Z (X1 - X0))^2 is x(P), so Z^2 = X' / (x(P) C)
+    CRYPTO_COUNT(CTR_FIELD_MUL);
+    CRYPTO_COUNT_N(CTR_FIELD_SQR, 2);
+    sub(s.T, A.X1, A.X0);
+    sqr(s.C, s.T);
+    add(s.T, A.Y1, A.Y0);
+    sqr(s.D, s.T);
+    add(s.T, A.X1, A.X0);
+    mul(s.T, s.T, s.C);
+    sub(s.D, s.D, s.T);
+    if (degenerate || IsZero(s.C) || IsZero(s.D)) return false;
+    CRYPTO_COUNT_N(CTR_FIELD_MUL, 3);
+    CRYPTO_COUNT(CTR_FIELD_INV);
+    inv(s.E, s.D);
+    mul(x, A.X0, P.x);
+    mul(x, x, s.C);
+    mul(x, x, s.E);
+    return true;
+}
@@ -0,0 +1,53 @@
+#include "elgamal.hpp"
+#include "drbg.hpp"
+
+using namespace std;
+using namespace NTL;
+
+ElGamalEncryptor::ElGamalEncryptor(const ZZ_p& g, const ZZ_p& h, long w)
+    : p(ZZ_p::modulus()),
+      gT(make_shared<const ModExpTable>(buildModExpTable(g, NumBits(ZZ_p::modulus()), w))),
+      hT(make_shared<const ModExpTable>(buildModExpTable(h, NumBits(ZZ_p::modulus()), w))) {}
+
+ElGamalEncryptor::Ephemeral ElGamalEncryptor::ephemeral(const ZZ& y) const {
+    return make_pair(fixedBasePower(*gT, y), fixedBasePower(*hT, y));
+}
+
+void ElGamalEncryptor::encrypt(const ZZ_p& m, ZZ_p& c1, ZZ_p& c2) const {
+    if (pool) {
+        unique_ptr<Ephemeral> e = pool->tryTake();
+        if (e) {
+            ZZ_pPush push(gT->ctx);
+            c1 = e->first;                // c1 = g^y mod p
+            c2 = m * e->second;           // c2 = m * h^y mod p
+            return;
+        }
+    }
+    encrypt(m, threadDRBG().randomRange(ZZ(1), p - 2), c1, c2);
+}
+
+void ElGamalEncryptor::encrypt(const ZZ_p& m, const ZZ& y, ZZ_p& c1, ZZ_p& c2) const {
+    ZZ_pPush push(gT->ctx);
+    Ephemeral e = ephemeral(y);
+    c1 = e.first;                         // c1 = g^y mod p
+    c2 = m * e.second;                    // c2 = m * s mod p, s = h^y
+}
+
+// Workers hold their own references to the tables, so the pool outlives moves of the encryptor
+void ElGamalEncryptor::startPool(size_t capacity, unsigned workers) {
+    shared_ptr<const ModExpTable> g = gT, h = hT;
+    ZZ pm2 = p - 2;
+    pool = make_shared<PrecomputePool<Ephemeral>>(capacity, [g, h, pm2] {
+        ZZ_pPush push(g->ctx);
+        ZZ y = threadDRBG().randomRange(ZZ(1), pm2);
+        return unique_ptr<Ephemeral>(new Ephemeral(fixedBasePower(*g, y), fixedBasePower(*h, y)));
+    }, workers);
+}
+
+void ElGamalEncryptor::stopPool() {
+    pool.reset();
+}
+
+PoolStats ElGamalEncryptor::poolStats() const {
+    return pool ? pool->stats() : PoolStats();
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <memory>
+#include <utility>
+#include <NTL/ZZ.h>
+#include <NTL/ZZ_p.h>
+#include "modexp.hpp"
+#include "precompute.hpp"
+
+// ElGamal encryption to one recipient (g, h = g^x) in the modulus current at construction.
+// Fixed-base tables for both g and h are built once, so each message costs two table walks
+// (about maxBits / w multiplications each) instead of two full exponentiations.
+// Memory is 2 * ceil(bits / w) * (2^w - 1) residues: about 4 MB for a 2048-bit p at w = 4.
+//
+// Offline/online: startPool keeps up to `capacity` message-independent pairs (g^y, h^y) ready on
+// background threads, and encrypt then costs one multiplication when the pool has an entry.
+// Copies share the tables and the pool.
+class ElGamalEncryptor {
+public:
+    ElGamalEncryptor(const NTL::ZZ_p& g, const NTL::ZZ_p& h, long w = 4);
+
+    // c1 = g^y, c2 = m * h^y with y uniform in [1, p-2], results in the encryptor's modulus
+    void encrypt(const NTL::ZZ_p& m, NTL::ZZ_p& c1, NTL::ZZ_p& c2) const;
+    // Same with a caller-chosen y (never uses the pool)
+    void encrypt(const NTL::ZZ_p& m, const NTL::ZZ& y, NTL::ZZ_p& c1, NTL::ZZ_p& c2) const;
+
+    void startPool(size_t capacity, unsigned workers = 1);
+    void stopPool();
+    PoolStats poolStats() const;
+
+    const NTL::ZZ& modulus() const { return p; }
+    const ModExpTable& gTable() const { return *gT; }
+    const ModExpTable& hTable() const { return *hT; }
+
+private:
+    typedef std::pair<NTL::ZZ_p, NTL::ZZ_p> Ephemeral;    // (g^y, h^y)
+
+    NTL::ZZ p;
+    std::shared_ptr<const ModExpTable> gT, hT;
+    std::shared_ptr<PrecomputePool<Ephemeral>> pool;
+
+    Ephemeral ephemeral(const NTL::ZZ& y) const;
+};
@@ -0,0 +1,210 @@
+#pragma once
+#include <cstdint>
+#include <NTL/ZZ.h>
+
+// Fixed-width prime field for 256-bit curve moduli: 4 x 64-bit limbs in Montgomery form,
+// no heap allocation. Params supplies the modulus P, R2 = 2^512 mod P and N0 = -P^-1 mod 2^64.
+// Drop-in field type for the templated point code in ecjacobian.hpp.
+
+typedef unsigned __int128 u128;
+
+// NIST P-256 prime 2^256 - 2^224 + 2^192 + 2^96 - 1
+struct P256Field {
+    static constexpr uint64_t P[4]  = { 0xffffffffffffffffULL, 0x00000000ffffffffULL, 0x0000000000000000ULL, 0xffffffff00000001ULL };
+    static constexpr uint64_t R2[4] = { 0x0000000000000003ULL, 0xfffffffbffffffffULL, 0xfffffffffffffffeULL, 0x00000004fffffffdULL };
+    static constexpr uint64_t N0    = 0x0000000000000001ULL;
+};
+
+// secp256k1 prime 2^256 - 2^32 - 977
+struct Secp256k1Field {
+    static constexpr uint64_t P[4]  = { 0xfffffffefffffc2fULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL };
+    static constexpr uint64_t R2[4] = { 0x000007a2000e90a1ULL, 0x0000000000000001ULL, 0x0000000000000000ULL, 0x0000000000000000ULL };
+    static constexpr uint64_t N0    = 0xd838091dd2253531ULL;
+};
+
+
+template<class Params>
+class Fp256 {
+public:
+    uint64_t v[4];      // Montgomery form a*2^256 mod P, fully reduced
+
+    Fp256() : v{0, 0, 0, 0} {}
+    explicit Fp256(long a) {
+        uint64_t t[4] = { (uint64_t)(a < 0 ? -a : a), 0, 0, 0 };
+        montMul(v, t, Params::R2);
+        if (a < 0) *this = -*this;
+    }
+
+    // NTL interop, a is taken mod P; reduced inputs (e.g. rep of a ZZ_p) convert without allocating
+    static Fp256 fromZZ(const NTL::ZZ& a) {
+        unsigned char buf[32];
+        if (a >= 0 && a < modulus()) {
+            NTL::BytesFromZZ(buf, a, 32);
+        } else {
+            thread_local NTL::ZZ r;
+            rem(r, a, modulus());
+            NTL::BytesFromZZ(buf, r, 32);
+        }
+        uint64_t t[4];
+        for (int i = 0; i < 4; i++) {
+            t[i] = 0;
+            for (int b = 7; b >= 0; b--) t[i] = (t[i] << 8) | buf[8 * i + b];
+        }
+        Fp256 x;
+        montMul(x.v, t, Params::R2);
+        return x;
+    }
+
+    NTL::ZZ toZZ() const {
+        NTL::ZZ x;
+        toZZ(x);
+        return x;
+    }
+
+    // Into an existing ZZ, reusing its limbs
+    void toZZ(NTL::ZZ& x) const {
+        static const uint64_t one[4] = { 1, 0, 0, 0 };
+        uint64_t t[4];
+        montMul(t, v, one);
+        unsigned char buf[32];
+        for (int i = 0; i < 4; i++) {
+            for (int b = 0; b < 8; b++) buf[8 * i + b] = (unsigned char)(t[i] >> (8 * b));
+        }
+        NTL::ZZFromBytes(x, buf, 32);
+    }
+
+    static const NTL::ZZ& modulus() {
+        static const NTL::ZZ p = [] {
+            unsigned char buf[32];
+            for (int i = 0; i < 4; i++) {
+                for (int b = 0; b < 8; b++) buf[8 * i + b] = (unsigned char)(Params::P[i] >> (8 * b));
+            }
+            return NTL::ZZFromBytes(buf, 32);
+        }();
+        return p;
+    }
+
+    // r = a*b/2^256 mod P (CIOS)
+    static void montMul(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+        uint64_t t[6] = { 0, 0, 0, 0, 0, 0 };
+        #pragma GCC unroll 4
+        for (int i = 0; i < 4; i++) {
+            u128 c = 0;
+            #pragma GCC unroll 4
+            for (int j = 0; j < 4; j++) {
+                c += (u128)a[i] * b[j] + t[j];
+                t[j] = (uint64_t)c;
+                c >>= 64;
+            }
+            c += t[4];
+            t[4] = (uint64_t)c;
+            t[5] = (uint64_t)(c >> 64);
+
+            uint64_t m = t[0] * Params::N0;
+            c = (u128)m * Params::P[0] + t[0];
+            c >>= 64;
+            #pragma GCC unroll 4
+            for (int j = 1; j < 4; j++) {
+                c += (u128)m * Params::P[j] + t[j];
+                t[j - 1] = (uint64_t)c;
+                c >>= 64;
+            }
+            c += t[4];
+            t[3] = (uint64_t)c;
+            t[4] = t[5] + (uint64_t)(c >> 64);
+        }
+        reduceOnce(r, t, t[4]);
+    }
+
+    // r = t - P if (carry:t) >= P, else t
+    static void reduceOnce(uint64_t r[4], const uint64_t t[4], uint64_t carry) {
+        uint64_t s[4];
+        u128 borrow = 0;
+        for (int j = 0; j < 4; j++) {
+            u128 d = (u128)t[j] - Params::P[j] - borrow;
+            s[j] = (uint64_t)d;
+            borrow = (d >> 64) & 1;
+        }
+        bool useS = carry || !borrow;
+        for (int j = 0; j < 4; j++) r[j] = useS ? s[j] : t[j];
+    }
+
+    friend Fp256 operator+(const Fp256& a, const Fp256& b) {
+        uint64_t t[4];
+        u128 c = 0;
+        for (int j = 0; j < 4; j++) {
+            c += (u128)a.v[j] + b.v[j];
+            t[j] = (uint64_t)c;
+            c >>= 64;
+        }
+        Fp256 r;
+        reduceOnce(r.v, t, (uint64_t)c);
+        return r;
+    }
+
+    friend Fp256 operator-(const Fp256& a, const Fp256& b) {
+        Fp256 r;
+        u128 borrow = 0;
+        for (int j = 0; j < 4; j++) {
+            u128 d = (u128)a.v[j] - b.v[j] - borrow;
+            r.v[j] = (uint64_t)d;
+            borrow = (d >> 64) & 1;
+        }
+        // add P back on underflow
+        uint64_t mask = 0 - (uint64_t)borrow;
+        u128 c = 0;
+        for (int j = 0; j < 4; j++) {
+            c += (u128)r.v[j] + (Params::P[j] & mask);
+            r.v[j] = (uint64_t)c;
+            c >>= 64;
+        }
+        return r;
+    }
+
+    friend Fp256 operator-(const Fp256& a) { return Fp256() - a; }
+
+    friend Fp256 operator*(const Fp256& a, const Fp256& b) {
+        Fp256 r;
+        montMul(r.v, a.v, b.v);
+        return r;
+    }
+
+    friend Fp256 sqr(const Fp256& a) { return a * a; }
+
+    // Inverse through NTL's extended gcd, much cheaper here than a 256-bit Fermat ladder.
+    // The ZZ register is per thread, so a warmed-up thread inverts without allocating.
+    friend Fp256 inv(const Fp256& a) {
+        if (IsZero(a)) return a;
+        thread_local NTL::ZZ t;
+        a.toZZ(t);
+        NTL::InvMod(t, t, modulus());
+        return fromZZ(t);
+    }
+
+    // NTL-style procedural forms, so the in-place point formulas serve ZZ_p and Fp256 alike
+    friend void add(Fp256& r, const Fp256& a, const Fp256& b) { r = a + b; }
+    friend void sub(Fp256& r, const Fp256& a, const Fp256& b) { r = a - b; }
+    friend void mul(Fp256& r, const Fp256& a, const Fp256& b) { montMul(r.v, a.v, b.v); }
+    friend void sqr(Fp256& r, const Fp256& a) { montMul(r.v, a.v, a.v); }
+    friend void negate(Fp256& r, const Fp256& a) { r = -a; }
+    friend void inv(Fp256& r, const Fp256& a) { r = inv(a); }
+    friend void clear(Fp256& r) { r = Fp256(); }
+    friend void set(Fp256& r) { r = Fp256(1); }
+
+    friend bool IsZero(const Fp256& a) { return (a.v[0] | a.v[1] | a.v[2] | a.v[3]) == 0; }
+
+    // (a, b) = (b, a) when c = 1, masked: no branch and the same addresses whatever c is
+    friend void condSwap(Fp256& a, Fp256& b, uint64_t c) {
+        uint64_t mask = 0 - c;
+        for (int j = 0; j < 4; j++) {
+            uint64_t t = (a.v[j] ^ b.v[j]) & mask;
+            a.v[j] ^= t;
+            b.v[j] ^= t;
+        }
+    }
+
+    friend bool operator==(const Fp256& a, const Fp256& b) {
+        return a.v[0] == b.v[0] && a.v[1] == b.v[1] && a.v[2] == b.v[2] && a.v[3] == b.v[3];
+    }
+    friend bool operator!=(const Fp256& a, const Fp256& b) { return !(a == b); }
+};
@@ -0,0 +1,142 @@
+#include "hill.hpp"
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace std;
+using namespace NTL;
+
+static const long HILL_MOD = HillKey::MOD;
+
+static inline long mod31(long x) {
+    x %= HILL_MOD;
+    return x < 0 ? x + HILL_MOD : x;
+}
+
+// Character -> value tables: c - 'A' mod 31, the encryption table upper-cases first
+struct HillCharMaps {
+    unsigned char enc[256], dec[256];
+    HillCharMaps() {
+        for (int u = 0; u < 256; u++) {
+            int c = (signed char)u;
+            dec[u] = (unsigned char)mod31(c - 'A');
+            enc[u] = (unsigned char)mod31((c >= 0 ? toupper(c) : c) - 'A');
+        }
+    }
+};
+
+static const HillCharMaps& charMaps() {
+    static const HillCharMaps maps;
+    return maps;
+}
+
+// out block b = M * (map of in block b), blocks of n characters, written as 'A' + value.
+// Blocks are transposed a tile at a time so each output row is a run of multiply-adds across
+// TILE blocks; with N fixed the row loop unrolls and 16-bit accumulators are enough.
+template<int N>
+static void hillBlocks(const unsigned char* M, long nRun, const unsigned char* map,
+                       const unsigned char* in, unsigned char* out, size_t blocks) {
+    typedef typename conditional<(N > 0 && N <= 16), uint16_t, uint32_t>::type Acc;
+    const long n = N > 0 ? N : nRun;
+    const size_t TILE = 256;
+
+    vector<Acc> rows(n * TILE);
+    Acc acc[TILE];
+    for (size_t b0 = 0; b0 < blocks; b0 += TILE) {
+        size_t m = min(TILE, blocks - b0);
+        const unsigned char* src = in + b0 * n;
+        for (size_t t = 0; t < m; t++) {
+            for (long j = 0; j < n; j++) rows[j * TILE + t] = map[src[t * n + j]];
+        }
+
+        unsigned char* dst = out + b0 * n;
+        for (long i = 0; i < n; i++) {
+            for (size_t t = 0; t < m; t++) acc[t] = 0;
+            for (long j = 0; j < n; j++) {
+                Acc k = M[i * n + j];
+                const Acc* row = &rows[j * TILE];
+                for (size_t t = 0; t < m; t++) acc[t] += k * row[t];
+            }
+            for (size_t t = 0; t < m; t++) dst[t * n + i] = (unsigned char)('A' + acc[t] % (Acc)HILL_MOD);
+        }
+    }
+}
+
+typedef void (*HillKernel)(const unsigned char*, long, const unsigned char*, const unsigned char*, unsigned char*, size_t);
+
+static HillKernel hillKernel(long n) {
+    static const HillKernel fixed[17] = {
+        nullptr, nullptr,
+        hillBlocks<2>,  hillBlocks<3>,  hillBlocks<4>,  hillBlocks<5>,  hillBlocks<6>,
+        hillBlocks<7>,  hillBlocks<8>,  hillBlocks<9>,  hillBlocks<10>, hillBlocks<11>,
+        hillBlocks<12>, hillBlocks<13>, hillBlocks<14>, hillBlocks<15>, hillBlocks<16>
+    };
+    if (n >= 2 && n <= 16) return fixed[n];
+    return hillBlocks<0>;
+}
+
+HillKey::HillKey(const mat_ZZ_p& key) : n(key.NumRows()) {
+    if (n == 0 || key.NumCols() != n) {
+        throw runtime_error("Hill key must be a non-empty square matrix");
+    }
+
+    K.resize(n * n);
+    for (long i = 0; i < n; i++) {
+        for (long j = 0; j < n; j++) K[i * n + j] = (unsigned char)(rep(key[i][j]) % HILL_MOD);
+    }
+
+    // Gauss-Jordan on [K | I] mod 31
+    vector<long> a(K.begin(), K.end()), b(n * n, 0);
+    for (long i = 0; i < n; i++) b[i * n + i] = 1;
+    for (long col = 0; col < n; col++) {
+        long piv = col;
+        while (piv < n && a[piv * n + col] == 0) piv++;
+        if (piv == n) {
+            throw runtime_error("Hill key is not invertible mod 31");
+        }
+        if (piv != col) {
+            for (long j = 0; j < n; j++) {
+                swap(a[piv * n + j], a[col * n + j]);
+                swap(b[piv * n + j], b[col * n + j]);
+            }
+        }
+
+        long pinv = 1;     // a^29 = a^-1 mod 31
+        for (long e = 0; e < HILL_MOD - 2; e++) pinv = pinv * a[col * n + col] % HILL_MOD;
+        for (long j = 0; j < n; j++) {
+            a[col * n + j] = a[col * n + j] * pinv % HILL_MOD;
+            b[col * n + j] = b[col * n + j] * pinv % HILL_MOD;
+        }
+
+        for (long r = 0; r < n; r++) {
+            long f = a[r * n + col];
+            if (r == col || f == 0) continue;
+            for (long j = 0; j < n; j++) {
+                a[r * n + j] = mod31(a[r * n + j] - f * a[col * n + j]);
+                b[r * n + j] = mod31(b[r * n + j] - f * b[col * n + j]);
+            }
+        }
+    }
+    Kinv.assign(b.begin(), b.end());
+}
+
+string HillKey::encrypt(string text) const {
+    while (text.size() % n != 0) text += 'X';
+
+    string result(text.size(), '\0');
+    hillKernel(n)(K.data(), n, charMaps().enc, (const unsigned char*)text.data(),
+                  (unsigned char*)&result[0], text.size() / n);
+    return result;
+}
+
+string HillKey::decrypt(const string& ciphertext) const {
+    if (ciphertext.size() % n != 0) {
+        throw runtime_error("Hill ciphertext length must be a multiple of the key size");
+    }
+
+    string result(ciphertext.size(), '\0');
+    hillKernel(n)(Kinv.data(), n, charMaps().dec, (const unsigned char*)ciphertext.data(),
+                  (unsigned char*)&result[0], ciphertext.size() / n);
+    return result;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <NTL/mat_ZZ_p.h>
+
+// Hill key compiled once: the n x n key and its inverse mod 31 as small integers.
+// Characters map to values as the original cipher did, c - 'A' reduced mod 31, and back as 'A' + v.
+// Messages are processed as one matrix-matrix product over all n-character blocks, with
+// n = 2..16 instantiated at compile time.
+class HillKey {
+public:
+    static const long MOD = 31;
+
+    // Entries are taken mod 31; throws runtime_error if the key is not square or not invertible mod 31
+    explicit HillKey(const NTL::mat_ZZ_p& key);
+
+    long size() const { return n; }
+    std::string encrypt(std::string text) const;         // upper-cases, pads with 'X' to a multiple of n
+    std::string decrypt(const std::string& ciphertext) const;
+
+    const std::vector<unsigned char>& forward() const { return K; }   // row-major, entries 0..30
+    const std::vector<unsigned char>& inverse() const { return Kinv; }
+
+private:
+    long n;
+    std::vector<unsigned char> K, Kinv;
+};
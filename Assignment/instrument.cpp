@@ -0,0 +1,184 @@
+#include "instrument.hpp"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+
+using namespace std;
+
+static const char* const COUNTER_NAMES[CTR_COUNT] = {
+    "field_mul", "field_sqr", "field_inv", "point_add", "point_double", "modexp", "rng_retry", "rng_reject"
+};
+
+static const char* const COUNTER_HELP[CTR_COUNT] = {
+    "Field multiplications issued by the EC formulas",
+    "Field squarings issued by the EC formulas",
+    "Field inversions issued by the EC formulas",
+    "Point additions (affine, Jacobian, mixed and co-Z)",
+    "Point doublings",
+    "Modular exponentiations",
+    "Nonces and keys drawn again after a degenerate value",
+    "Out-of-range samples rejected by the DRBG"
+};
+
+const char* counterName(InstrumentCounter c) {
+    return c >= 0 && c < CTR_COUNT ? COUNTER_NAMES[c] : "unknown";
+}
+
+#ifdef CRYPTO_INSTRUMENT
+namespace instr {
+
+atomic<bool> timersEnabled{ false };
+
+ThreadBlock::ThreadBlock() {
+    for (auto& c : counters) c.store(0, memory_order_relaxed);
+    for (auto& c : calls) c.store(0, memory_order_relaxed);
+    for (auto& n : nanos) n.store(0, memory_order_relaxed);
+}
+
+// Never destroyed: threads may still retire their blocks during static destruction
+struct Registry {
+    mutex m;
+    vector<ThreadBlock*> live;
+    ThreadBlock retired;                // totals of exited threads
+    vector<string> timerNames;
+    InstrumentStats baseline;           // raw totals at the last reset
+};
+
+static Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+BlockHandle::BlockHandle() : block(new ThreadBlock) {
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.m);
+    r.live.push_back(block);
+}
+
+BlockHandle::~BlockHandle() {
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.m);
+    for (int c = 0; c < CTR_COUNT; c++) bump(r.retired.counters[c], block->counters[c].load(memory_order_relaxed));
+    for (int t = 0; t < MAX_TIMERS; t++) {
+        bump(r.retired.calls[t], block->calls[t].load(memory_order_relaxed));
+        bump(r.retired.nanos[t], block->nanos[t].load(memory_order_relaxed));
+    }
+    r.live.erase(find(r.live.begin(), r.live.end(), block));
+    delete block;
+}
+
+int timerSlot(const char* method) {
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.m);
+    for (size_t i = 0; i < r.timerNames.size(); i++) {
+        if (r.timerNames[i] == method) return (int)i;
+    }
+    if (r.timerNames.size() >= (size_t)MAX_TIMERS) return -1;
+    r.timerNames.push_back(method);
+    return (int)r.timerNames.size() - 1;
+}
+
+uint64_t nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Sum of the retired block and every live one; the caller holds the registry lock
+static InstrumentStats rawTotals(Registry& r) {
+    InstrumentStats s;
+    vector<const ThreadBlock*> blocks(r.live.begin(), r.live.end());
+    blocks.push_back(&r.retired);
+    s.methods.resize(r.timerNames.size());
+    for (size_t t = 0; t < s.methods.size(); t++) s.methods[t].method = r.timerNames[t];
+    for (const ThreadBlock* b : blocks) {
+        for (int c = 0; c < CTR_COUNT; c++) s.counters[c] += b->counters[c].load(memory_order_relaxed);
+        for (size_t t = 0; t < s.methods.size(); t++) {
+            s.methods[t].calls += b->calls[t].load(memory_order_relaxed);
+            s.methods[t].nanos += b->nanos[t].load(memory_order_relaxed);
+        }
+    }
+    return s;
+}
+
+}
+
+bool instrumentationEnabled() {
+    return true;
+}
+
+// Reset keeps a baseline instead of zeroing the blocks, which only their own threads may write
+InstrumentStats instrumentSnapshot() {
+    instr::Registry& r = instr::registry();
+    lock_guard<mutex> lock(r.m);
+    InstrumentStats s = instr::rawTotals(r);
+    for (int c = 0; c < CTR_COUNT; c++) s.counters[c] -= r.baseline.counters[c];
+    for (size_t t = 0; t < r.baseline.methods.size(); t++) {
+        s.methods[t].calls -= r.baseline.methods[t].calls;
+        s.methods[t].nanos -= r.baseline.methods[t].nanos;
+    }
+    return s;
+}
+
+void instrumentReset() {
+    instr::Registry& r = instr::registry();
+    lock_guard<mutex> lock(r.m);
+    r.baseline = instr::rawTotals(r);
+}
+
+void enableMethodTimers(bool enable) {
+    instr::timersEnabled.store(enable, memory_order_relaxed);
+}
+#else
+bool instrumentationEnabled() {
+    return false;
+}
+
+InstrumentStats instrumentSnapshot() {
+    return InstrumentStats();
+}
+
+void instrumentReset() {}
+
+void enableMethodTimers(bool) {}
+#endif
+
+// Label values escape backslash, quote and newline
+static string promLabel(const string& v) {
+    string out;
+    for (char c : v) {
+        if (c == '\\' || c == '"') out += '\\';
+        if (c == '\n') {
+            out += "\\n";
+            continue;
+        }
+        out += c;
+    }
+    return out;
+}
+
+string instrumentPrometheus(const string& prefix) {
+    InstrumentStats s = instrumentSnapshot();
+    ostringstream out;
+    out << "# HELP " << prefix << "_instrumentation_enabled 1 when built with CRYPTO_INSTRUMENT\n";
+    out << "# TYPE " << prefix << "_instrumentation_enabled gauge\n";
+    out << prefix << "_instrumentation_enabled " << (instrumentationEnabled() ? 1 : 0) << "\n";
+    for (int c = 0; c < CTR_COUNT; c++) {
+        string name = prefix + "_" + COUNTER_NAMES[c] + "_total";
+        out << "# HELP " << name << " " << COUNTER_HELP[c] << "\n";
+        out << "# TYPE " << name << " counter\n";
+        out << name << " " << s.counters[c] << "\n";
+    }
+    if (s.methods.empty()) return out.str();
+
+    out << "# HELP " << prefix << "_method_calls_total Calls of timed public methods\n";
+    out << "# TYPE " << prefix << "_method_calls_total counter\n";
+    for (const MethodTiming& m : s.methods) {
+        out << prefix << "_method_calls_total{method=\"" << promLabel(m.method) << "\"} " << m.calls << "\n";
+    }
+    out << "# HELP " << prefix << "_method_seconds_total Wall time in timed public methods, nested timed calls included\n";
+    out << "# TYPE " << prefix << "_method_seconds_total counter\n";
+    for (const MethodTiming& m : s.methods) {
+        out << prefix << "_method_seconds_total{method=\"" << promLabel(m.method) << "\"} " << m.nanos / 1e9 << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hot-path operation counters and method timers, compiled in only with -DCRYPTO_INSTRUMENT (CMake
+// option CRYPTO_INSTRUMENT). Without it the hooks below expand to nothing and snapshots are all zero.
+//
+// Counters are per thread: each thread bumps its own block with a relaxed load and store, so counting
+// never contends. Blocks register on a thread's first event and fold into a shared total when the
+// thread exits. Field operations are counted where the EC formulas issue them (ecjacobian.hpp and the
+// affine point code), for the ZZ_p and fixed-width backends alike.
+//
+// Method timers sit only on the public-key operations the benchmarks report (modexp, scalar multiply,
+// sign, verify, encrypt, decrypt), each named by its function, so overloads share one timer.
+
+enum InstrumentCounter {
+    CTR_FIELD_MUL,
+    CTR_FIELD_SQR,
+    CTR_FIELD_INV,
+    CTR_POINT_ADD,
+    CTR_POINT_DOUBLE,
+    CTR_MODEXP,         // modular exponentiations (PowerMod, sliding window, fixed base, multi-exponentiation)
+    CTR_RNG_RETRY,      // nonces and keys drawn again: zero draws, r = 0, s = 0, infinity, gcd != 1
+    CTR_RNG_REJECT,     // out-of-range samples rejected inside the DRBG
+    CTR_COUNT
+};
+
+const char* counterName(InstrumentCounter c);   // "field_mul", ...
+
+struct MethodTiming {
+    std::string method;
+    uint64_t calls = 0;
+    uint64_t nanos = 0;     // wall time, including nested timed calls
+};
+
+struct InstrumentStats {
+    uint64_t counters[CTR_COUNT] = {};
+    std::vector<MethodTiming> methods;      // every timer registered so far, calls may be 0
+};
+
+bool instrumentationEnabled();              // built with CRYPTO_INSTRUMENT
+// Totals over all threads since the last reset. Events racing with a snapshot land in this one or the next.
+InstrumentStats instrumentSnapshot();
+void instrumentReset();
+// Scoped method timers cost two clock reads per call, so they stay off until enabled
+void enableMethodTimers(bool enable);
+// Snapshot in the Prometheus text exposition format, metric names starting with prefix_
+std::string instrumentPrometheus(const std::string& prefix = "crypto");
+
+
+#ifdef CRYPTO_INSTRUMENT
+namespace instr {
+
+const int MAX_TIMERS = 128;
+
+struct alignas(64) ThreadBlock {
+    std::atomic<uint64_t> counters[CTR_COUNT];
+    std::atomic<uint64_t> calls[MAX_TIMERS];
+    std::atomic<uint64_t> nanos[MAX_TIMERS];
+    ThreadBlock();
+};
+
+// Registers the calling thread's block on construction and retires it on thread exit
+struct BlockHandle {
+    ThreadBlock* block;
+    BlockHandle();
+    ~BlockHandle();
+};
+
+inline ThreadBlock& threadBlock() {
+    thread_local BlockHandle h;
+    return *h.block;
+}
+
+// Only the owning thread writes its block, so a plain load + store is enough
+inline void bump(std::atomic<uint64_t>& v, uint64_t n) {
+    v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void count(InstrumentCounter c, uint64_t n) {
+    bump(threadBlock().counters[c], n);
+}
+
+extern std::atomic<bool> timersEnabled;
+
+// Slot for a method name, shared by every call site with that name; -1 once MAX_TIMERS are taken
+int timerSlot(const char* method);
+uint64_t nowNanos();
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(int slot) : slot(timersEnabled.load(std::memory_order_relaxed) ? slot : -1) {
+        if (this->slot >= 0) start = nowNanos();
+    }
+    ~ScopedTimer() {
+        if (slot < 0) return;
+        ThreadBlock& b = threadBlock();
+        bump(b.calls[slot], 1);
+        bump(b.nanos[slot], nowNanos() - start);
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    int slot;
+    uint64_t start = 0;
+};
+
+}
+
+#define CRYPTO_COUNT(c) instr::count(c, 1)
+#define CRYPTO_COUNT_N(c, n) instr::count(c, n)
+#define CRYPTO_TIMED() \
+    static const int instrTimerSlot = instr::timerSlot(__func__); \
+    instr::ScopedTimer instrTimer(instrTimerSlot)
+#else
+#define CRYPTO_COUNT(c) ((void)0)
+#define CRYPTO_COUNT_N(c, n) ((void)0)
+#define CRYPTO_TIMED() ((void)0)
+#endif
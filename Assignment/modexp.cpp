@@ -0,0 +1,194 @@
+#include "modexp.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace NTL;
+
+// Window width minimizing squarings + table + window multiplications for an expBits-bit exponent
+long slidingWindowWidth(long expBits) {
+    if (expBits <= 24) return 1;
+    if (expBits <= 80) return 3;
+    if (expBits <= 240) return 4;
+    if (expBits <= 672) return 5;
+    if (expBits <= 1792) return 6;
+    return 7;
+}
+
+ExpRecoding slidingWindowRecode(const ZZ& e, long w) {
+    if (e <= 0) throw runtime_error("slidingWindowRecode: exponent must be positive");
+    ExpRecoding r;
+    r.w = w;
+    long squarings = 0;
+    for (long i = NumBits(e) - 1; i >= 0;) {
+        if (!bit(e, i)) {
+            squarings++;
+            i--;
+            continue;
+        }
+        // longest window [j, i] of at most w bits that ends in a 1
+        long j = max(i - w + 1, 0L);
+        while (!bit(e, j)) j++;
+        long d = 0;
+        for (long k = i; k >= j; k--) d = 2 * d + bit(e, k);
+        squarings += i - j + 1;
+        r.steps.push_back(make_pair(squarings, d));
+        squarings = 0;
+        i = j - 1;
+    }
+    if (squarings > 0) r.steps.push_back(make_pair(squarings, 0L));
+    return r;
+}
+
+ZZ_p slidingWindowPower(const ZZ_p& a, const ExpRecoding& r) {
+    CRYPTO_COUNT(CTR_MODEXP);
+    // odd powers a, a^3, ..., a^(2^w - 1)
+    long m = 1L << (r.w - 1);
+    vector<ZZ_p> odd(m);
+    odd[0] = a;
+    if (m > 1) {
+        ZZ_p a2;
+        sqr(a2, a);
+        for (long i = 1; i < m; i++) mul(odd[i], odd[i - 1], a2);
+    }
+
+    ZZ_p x;
+    bool started = false;
+    for (const auto& s : r.steps) {
+        if (!started) {
+            // leading squarings of 1 are free
+            x = odd[s.second >> 1];
+            started = true;
+            continue;
+        }
+        for (long k = 0; k < s.first; k++) sqr(x, x);
+        if (s.second) mul(x, x, odd[s.second >> 1]);
+    }
+    if (!started) set(x);
+    return x;
+}
+
+ZZ_p slidingWindowPower(const ZZ_p& a, const ZZ& e) {
+    if (IsZero(e)) return ZZ_p(1);
+    if (e < 0) return slidingWindowPower(inv(a), -e);
+    return slidingWindowPower(a, slidingWindowRecode(e, slidingWindowWidth(NumBits(e))));
+}
+
+// Bucket window minimizing windows * (n + 2^(c+1)) for n bases
+static long pippengerWidth(size_t n, long bits) {
+    long best = 1;
+    double bestCost = 0;
+    for (long c = 1; c <= 16; c++) {
+        double cost = double((bits + c - 1) / c) * (double(n) + double(1L << (c + 1)));
+        if (c == 1 || cost < bestCost) {
+            best = c;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+ZZ_p multiPower(const vector<ZZ_p>& bases, const vector<ZZ>& exps) {
+    if (bases.size() != exps.size()) throw runtime_error("multiPower: bases and exponents differ in length");
+    size_t n = bases.size();
+    long bits = 0;
+    for (const ZZ& e : exps) {
+        if (e < 0) throw runtime_error("multiPower: exponents must be non-negative");
+        bits = max(bits, NumBits(e));
+    }
+    ZZ_p x;
+    set(x);
+    if (bits == 0) return x;
+    CRYPTO_COUNT(CTR_MODEXP);
+
+    // little-endian exponent bytes, read c bits at a time
+    long nbytes = (bits + 7) / 8 + 2;
+    vector<unsigned char> bytes(n * nbytes);
+    for (size_t i = 0; i < n; i++) BytesFromZZ(&bytes[i * nbytes], exps[i], nbytes);
+    auto digit = [&](size_t i, long pos, long c) {
+        const unsigned char* b = &bytes[i * nbytes + pos / 8];
+        unsigned long v = b[0] | (unsigned long)b[1] << 8 | (unsigned long)b[2] << 16;
+        return long((v >> (pos % 8)) & ((1UL << c) - 1));
+    };
+
+    long c = pippengerWidth(n, bits);
+    long windows = (bits + c - 1) / c;
+    vector<ZZ_p> bucket(1L << c);
+    vector<char> used(1L << c);
+    bool started = false;
+    for (long wi = windows - 1; wi >= 0; wi--) {
+        if (started) {
+            for (long k = 0; k < c; k++) sqr(x, x);
+        }
+        fill(used.begin(), used.end(), 0);
+        for (size_t i = 0; i < n; i++) {
+            long d = digit(i, wi * c, c);
+            if (!d) continue;
+            if (used[d]) mul(bucket[d], bucket[d], bases[i]);
+            else {
+                bucket[d] = bases[i];
+                used[d] = 1;
+            }
+        }
+        // prod_d bucket[d]^d = running products of the buckets from the top down
+        ZZ_p run, sum;
+        bool haveRun = false, haveSum = false;
+        for (long d = (1L << c) - 1; d >= 1; d--) {
+            if (used[d]) {
+                if (haveRun) mul(run, run, bucket[d]);
+                else run = bucket[d];
+                haveRun = true;
+            }
+            if (!haveRun) continue;
+            if (haveSum) mul(sum, sum, run);
+            else sum = run;
+            haveSum = true;
+        }
+        if (haveSum) {
+            if (started) mul(x, x, sum);
+            else x = sum;
+            started = true;
+        }
+    }
+    return x;
+}
+
+ModExpTable buildModExpTable(const ZZ_p& g, long maxBits, long w) {
+    if (w < 1 || w > 10) throw runtime_error("Fixed-base window width must be in [1, 10]");
+    if (maxBits < 1) throw runtime_error("Fixed-base table needs a positive exponent size");
+
+    ModExpTable T;
+    T.ctx.save();
+    T.g = g;
+    T.w = w;
+    T.maxBits = maxBits;
+
+    long windows = (maxBits + w - 1) / w;
+    long m = (1L << w) - 1;
+    T.rows.resize(windows);
+    ZZ_p base = g;                          // g^(2^(w*i))
+    for (long i = 0; i < windows; i++) {
+        vector<ZZ_p>& row = T.rows[i];
+        row.resize(m);
+        row[0] = base;
+        for (long j = 1; j < m; j++) mul(row[j], row[j - 1], base);
+        mul(base, row[m - 1], base);       // base^(2^w)
+    }
+    return T;
+}
+
+ZZ_p fixedBasePower(const ModExpTable& T, const ZZ& e) {
+    ZZ_pPush push(T.ctx);
+    if (e < 0 || NumBits(e) > T.maxBits) return slidingWindowPower(T.g, e);
+    CRYPTO_COUNT(CTR_MODEXP);
+
+    ZZ_p x;
+    set(x);
+    long windows = (NumBits(e) + T.w - 1) / T.w;
+    for (long i = 0; i < windows; i++) {
+        long d = 0;
+        for (long k = T.w - 1; k >= 0; k--) d = 2 * d + bit(e, i * T.w + k);
+        if (d) mul(x, x, T.rows[i][d - 1]);
+    }
+    return x;
+}
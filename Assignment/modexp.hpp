@@ -0,0 +1,65 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include <NTL/ZZ.h>
+#include <NTL/ZZ_p.h>
+#include "instrument.hpp"
+
+// Modular exponentiation in the current ZZ_p modulus with full-size ZZ exponents
+
+// Left-to-right sliding-window recoding of e > 0: (squarings, odd digit) steps applied in order,
+// starting from 1. Shared by every base raised to the same exponent.
+struct ExpRecoding {
+    long w = 0;
+    std::vector<std::pair<long, long>> steps;
+};
+ExpRecoding slidingWindowRecode(const NTL::ZZ& e, long w);
+long slidingWindowWidth(long expBits);
+
+// a^e; negative e uses a^-1
+NTL::ZZ_p slidingWindowPower(const NTL::ZZ_p& a, const NTL::ZZ& e);
+NTL::ZZ_p slidingWindowPower(const NTL::ZZ_p& a, const ExpRecoding& r);
+
+// a^e for any field type with *, sqr and F(1) (e.g. Fp256), same window schedule
+template<class F>
+F recodedPower(const F& a, const ExpRecoding& r) {
+    CRYPTO_COUNT(CTR_MODEXP);
+    long m = 1L << (r.w - 1);
+    std::vector<F> odd(m);
+    odd[0] = a;
+    if (m > 1) {
+        F a2 = sqr(a);
+        for (long i = 1; i < m; i++) odd[i] = odd[i - 1] * a2;
+    }
+    F x(1);
+    bool started = false;
+    for (const auto& s : r.steps) {
+        if (!started) {
+            x = odd[s.second >> 1];
+            started = true;
+            continue;
+        }
+        for (long k = 0; k < s.first; k++) x = sqr(x);
+        if (s.second) x = x * odd[s.second >> 1];
+    }
+    return x;
+}
+
+// prod bases[i]^exps[i] for exps[i] >= 0 (Pippenger): every c-bit window drops each base into the
+// bucket of its digit and folds the buckets with running products, so n bases cost about
+// bits/c * (n + 2^(c+1)) multiplications plus one shared run of squarings
+NTL::ZZ_p multiPower(const std::vector<NTL::ZZ_p>& bases, const std::vector<NTL::ZZ>& exps);
+
+// Fixed-base table for g modulo p: rows[i][j-1] = g^(j * 2^(w*i)), covering exponents of up to maxBits bits.
+// g^e is then one multiplication per nonzero w-bit window, no squarings.
+struct ModExpTable {
+    NTL::ZZ_pContext ctx;   // modulus the table was built in, installed while it is used
+    NTL::ZZ_p g;
+    long w = 0;
+    long maxBits = 0;
+    std::vector<std::vector<NTL::ZZ_p>> rows;
+};
+ModExpTable buildModExpTable(const NTL::ZZ_p& g, long maxBits, long w);
+// g^e in T's modulus (the caller's modulus is restored afterwards); wider or negative e fall back
+// to slidingWindowPower
+NTL::ZZ_p fixedBasePower(const ModExpTable& T, const NTL::ZZ& e);
@@ -0,0 +1,214 @@
+#pragma once
+#include <thread>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+
+// Number of worker threads to use: `requested`, or one per hardware thread when 0
+inline unsigned workerCount(unsigned requested) {
+    if (requested > 0) return requested;
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+// Split [0, n) into `threads` contiguous shards and run body(begin, end) on each in its own thread.
+// The first exception thrown by any shard is rethrown in the caller after all shards have joined.
+template<class Body>
+void parallelFor(size_t n, unsigned threads, Body body) {
+    threads = (unsigned)std::min<size_t>(workerCount(threads), std::max<size_t>(n, 1));
+    if (threads <= 1) {
+        body(size_t(0), n);
+        return;
+    }
+
+    std::vector<std::thread> pool;
+    std::vector<std::exception_ptr> errors(threads);
+    size_t chunk = (n + threads - 1) / threads;
+    for (unsigned t = 0; t < threads; t++) {
+        size_t begin = std::min(n, t * chunk);
+        size_t end = std::min(n, begin + chunk);
+        pool.emplace_back([&, t, begin, end] {
+            try {
+                body(begin, end);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (auto& th : pool) th.join();
+    for (auto& e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+// Persistent work-stealing pool: size() workers, the thread calling run() being worker 0 and the rest
+// long-lived threads that sleep between runs. run(n, grain, body) covers [0, n): each worker starts on
+// its own contiguous shard and takes `grain` items at a time from the front; a worker whose shard is
+// empty steals the back half of another worker's shard. body(begin, end, worker) gets the worker index
+// in [0, size()) so callers can keep per-worker scratch. Runs from several threads take turns, one at
+// a time. A run() on the same pool from inside a body does not wait for that turn: it runs inline on
+// the calling worker, serially, with that worker's index. Exceptions are handled as in parallelFor.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned threads = 0) : workers(workerCount(threads)) {
+        for (unsigned t = 0; t < workers; t++) shards.emplace_back(new Shard);
+        for (unsigned t = 1; t < workers; t++) pool.emplace_back([this, t] { loop(t); });
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& th : pool) th.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return workers; }
+
+    template<class Body>
+    void run(size_t n, size_t grain, Body body) {
+        grain = std::max<size_t>(grain, 1);
+        Active& a = active();
+        if (a.pool == this) {
+            for (size_t b = 0; b < n; b += grain) body(b, std::min(n, b + grain), a.worker);
+            return;
+        }
+
+        std::lock_guard<std::mutex> turn(runLock);
+        if (workers <= 1 || n <= grain) {
+            Running running(this, 0);
+            for (size_t b = 0; b < n; b += grain) body(b, std::min(n, b + grain), 0u);
+            return;
+        }
+
+        size_t chunk = (n + workers - 1) / workers;
+        for (unsigned t = 0; t < workers; t++) {
+            std::lock_guard<std::mutex> lock(shards[t]->m);
+            shards[t]->begin = std::min(n, t * chunk);
+            shards[t]->end = std::min(n, shards[t]->begin + chunk);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m);
+            job = [&body](size_t b, size_t e, unsigned t) { body(b, e, t); };
+            jobGrain = grain;
+            errors.assign(workers, nullptr);
+            pending = workers - 1;
+            generation++;
+        }
+        wake.notify_all();
+
+        try {
+            work(0);
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+        {
+            std::unique_lock<std::mutex> lock(m);
+            done.wait(lock, [&] { return pending == 0; });
+            job = nullptr;
+        }
+        for (auto& e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+    }
+
+private:
+    struct Shard {
+        std::mutex m;
+        size_t begin = 0, end = 0;
+    };
+
+    // The pool and worker the calling thread is running a body for, so a nested run() can go inline
+    struct Active {
+        const WorkStealingPool* pool = nullptr;
+        unsigned worker = 0;
+    };
+    static Active& active() {
+        thread_local Active a;
+        return a;
+    }
+    struct Running {
+        Active saved;
+        Running(const WorkStealingPool* pool, unsigned worker) : saved(active()) { active() = { pool, worker }; }
+        ~Running() { active() = saved; }
+    };
+
+    const unsigned workers;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<std::thread> pool;
+
+    std::mutex runLock;                 // one run at a time
+    std::mutex m;                       // guards the job state below
+    std::condition_variable wake, done;
+    std::function<void(size_t, size_t, unsigned)> job;
+    size_t jobGrain = 1;
+    std::vector<std::exception_ptr> errors;
+    uint64_t generation = 0;            // bumped per run
+    unsigned pending = 0;               // pool threads still working on this run
+    bool stopping = false;
+
+    void loop(unsigned t) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            try {
+                work(t);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(m);
+            if (--pending == 0) done.notify_one();
+        }
+    }
+
+    void work(unsigned t) {
+        Running running(this, t);
+        Shard& own = *shards[t];
+        for (;;) {
+            size_t b = 0, e = 0;
+            {
+                std::lock_guard<std::mutex> lock(own.m);
+                if (own.begin < own.end) {
+                    b = own.begin;
+                    e = std::min(own.end, b + jobGrain);
+                    own.begin = e;
+                }
+            }
+            if (b < e) {
+                job(b, e, t);
+                continue;
+            }
+
+            bool stole = false;
+            for (unsigned v = 1; v < workers && !stole; v++) {
+                Shard& victim = *shards[(t + v) % workers];
+                std::lock_guard<std::mutex> lock(victim.m);
+                size_t left = victim.end - victim.begin;
+                if (left == 0) continue;
+                b = victim.begin + left / 2;
+                e = victim.end;
+                victim.end = b;
+                stole = true;
+            }
+            if (!stole) return;
+
+            std::lock_guard<std::mutex> lock(own.m);
+            own.begin = b;
+            own.end = e;
+        }
+    }
+};
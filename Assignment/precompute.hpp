@@ -0,0 +1,340 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Bounded multi-producer multi-consumer queue (Vyukov): each slot carries a sequence number that
+// tells producers and consumers whose turn it is, so push and pop are a CAS on the head or tail
+// and never take a lock. T must be default-constructible and movable.
+template<class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : cap(capacity > 0 ? capacity : 1), slots(new Slot[cap]), head(0), tail(0) {
+        for (size_t i = 0; i < cap; i++) slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Moves v into the queue; false (v untouched) when full
+    bool tryPush(T& v) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& s = slots[pos % cap];
+            size_t seq = s.seq.load(std::memory_order_acquire);
+            if (seq == pos) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    s.value = std::move(v);
+                    s.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (seq < pos) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Moves the oldest entry into out; false when empty
+    bool tryPop(T& out) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& s = slots[pos % cap];
+            size_t seq = s.seq.load(std::memory_order_acquire);
+            if (seq == pos + 1) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(s.value);
+                    s.value = T();
+                    s.seq.store(pos + cap, std::memory_order_release);
+                    return true;
+                }
+            } else if (seq < pos + 1) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Approximate while producers or consumers are active
+    size_t size() const {
+        size_t t = tail.load(std::memory_order_acquire), h = head.load(std::memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+    size_t capacity() const { return cap; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        T value;
+    };
+    size_t cap;
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+
+// Pool metrics: hit rate is takes served from the pool over all takes, refill rate is entries
+// produced per second since the pool started
+struct PoolStats {
+    size_t depth = 0;
+    size_t capacity = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t produced = 0;
+    double hitRate = 0;
+    double refillRate = 0;
+};
+
+// Background workers keep a BoundedQueue of make() results topped up. Consumers call tryTake, which
+// never blocks: on a miss the caller computes inline. Workers sleep while the queue is full and are
+// woken by the take that makes room. make() allocates each entry itself, so it can install whatever
+// thread context T needs (e.g. a ZZ_p modulus) while constructing it. The destructor stops and joins
+// the workers; entries still queued are destroyed with the pool.
+template<class T>
+class PrecomputePool {
+public:
+    PrecomputePool(size_t capacity, std::function<std::unique_ptr<T>()> make, unsigned workers = 1)
+        : queue(capacity), make(std::move(make)), start(std::chrono::steady_clock::now()) {
+        for (unsigned i = 0; i < (workers > 0 ? workers : 1); i++) threads.emplace_back([this] { run(); });
+    }
+
+    ~PrecomputePool() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    PrecomputePool(const PrecomputePool&) = delete;
+    PrecomputePool& operator=(const PrecomputePool&) = delete;
+
+    // Hands out each entry exactly once; null on a miss
+    std::unique_ptr<T> tryTake() {
+        std::unique_ptr<T> out;
+        if (!queue.tryPop(out)) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return out;
+        }
+        hits.fetch_add(1, std::memory_order_relaxed);
+        if (sleepers.load(std::memory_order_acquire) > 0) {
+            std::lock_guard<std::mutex> lock(m);
+            cv.notify_one();
+        }
+        return out;
+    }
+
+    PoolStats stats() const {
+        PoolStats s;
+        s.depth = queue.size();
+        s.capacity = queue.capacity();
+        s.hits = hits.load(std::memory_order_relaxed);
+        s.misses = misses.load(std::memory_order_relaxed);
+        s.produced = produced.load(std::memory_order_relaxed);
+        if (s.hits + s.misses > 0) s.hitRate = (double)s.hits / (s.hits + s.misses);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (secs > 0) s.refillRate = s.produced / secs;
+        return s;
+    }
+
+private:
+    BoundedQueue<std::unique_ptr<T>> queue;
+    std::function<std::unique_ptr<T>()> make;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<uint64_t> hits{ 0 }, misses{ 0 }, produced{ 0 };
+    std::atomic<int> sleepers{ 0 };
+    std::mutex m;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+    bool stopRequested() {
+        std::lock_guard<std::mutex> lock(m);
+        return stopping;
+    }
+
+    void run() {
+#if defined(__linux__)
+        // refills run at idle priority so they never delay the request path when cores are scarce
+        sched_param idle{};
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &idle);
+#endif
+        try {
+            while (!stopRequested()) {
+                if (queue.size() >= queue.capacity()) {
+                    std::unique_lock<std::mutex> lock(m);
+                    sleepers.fetch_add(1, std::memory_order_acq_rel);
+                    // the timeout bounds a wakeup lost between a take's unlocked pop and this check
+                    cv.wait_for(lock, std::chrono::milliseconds(20),
+                                [&] { return stopping || queue.size() < queue.capacity(); });
+                    sleepers.fetch_sub(1, std::memory_order_acq_rel);
+                    continue;
+                }
+                std::unique_ptr<T> item = make();
+                if (queue.tryPush(item)) produced.fetch_add(1, std::memory_order_relaxed);
+            }
+        } catch (...) {
+            // a failing make() retires this worker; takes fall back to inline computation
+        }
+    }
+};
+
+
+// Cache metrics: hit rate is lookups answered with a built table over all lookups, entries counts the
+// keys tracked (with or without a table), bytes is the footprint of the tables currently held
+struct CacheStats {
+    size_t entries = 0;
+    size_t tables = 0;
+    size_t capacity = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t builds = 0;
+    uint64_t evictions = 0;
+    size_t bytes = 0;
+    double hitRate = 0;
+};
+
+// Bounded map from a key to a table built on demand. A key first gets a use counter on a probation
+// list; the lookup that brings it to `buildAfter` uses moves it to the table list and builds its table.
+// Both lists hold up to `capacity` keys and drop the least recently used one, so keys that come up
+// rarely cycle through probation without ever costing a build, and never push out a table.
+// Lookups hold one mutex for the list updates only: the build runs outside it, and lookups that find
+// a table still being built get null and take the uncached path. Tables are shared_ptr, so an evicted
+// table stays alive for callers still using it. V must provide size_t bytes() const.
+template<class V>
+class TableCache {
+public:
+    TableCache(size_t capacity, uint64_t buildAfter)
+        : cap(capacity > 0 ? capacity : 1), threshold(buildAfter > 0 ? buildAfter : 1) {}
+
+    TableCache(const TableCache&) = delete;
+    TableCache& operator=(const TableCache&) = delete;
+
+    // The table for key, built with make() on its buildAfter-th use; null before that
+    std::shared_ptr<const V> lookup(const std::string& key, const std::function<std::shared_ptr<const V>()>& make) {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            auto it = index.find(key);
+            if (it != index.end() && it->second.inTables) {
+                Entry& e = *it->second.at;
+                tableList.splice(tableList.begin(), tableList, it->second.at);
+                if (e.table) {
+                    hits++;
+                    return e.table;
+                }
+                misses++;
+                return nullptr;                 // still building
+            }
+            misses++;
+            if (it == index.end()) it = admit(key);
+            else probation.splice(probation.begin(), probation, it->second.at);
+            if (++it->second.at->uses < threshold) return nullptr;
+            promote(it);
+        }
+
+        std::shared_ptr<const V> table;
+        try {
+            table = make();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m);
+            drop(key);
+            throw;
+        }
+
+        std::lock_guard<std::mutex> lock(m);
+        builds++;
+        // the entry may have been evicted while building
+        auto it = index.find(key);
+        if (it != index.end() && it->second.inTables && !it->second.at->table) {
+            it->second.at->table = table;
+            tables++;
+            bytes += table->bytes();
+        }
+        return table;
+    }
+
+    CacheStats stats() const {
+        std::lock_guard<std::mutex> lock(m);
+        CacheStats s;
+        s.entries = index.size();
+        s.tables = tables;
+        s.capacity = cap;
+        s.hits = hits;
+        s.misses = misses;
+        s.builds = builds;
+        s.evictions = evictions;
+        s.bytes = bytes;
+        if (hits + misses > 0) s.hitRate = (double)hits / (hits + misses);
+        return s;
+    }
+
+    size_t capacity() const { return cap; }
+    uint64_t buildAfter() const { return threshold; }
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t uses = 0;
+        std::shared_ptr<const V> table;     // null on probation and while building
+    };
+    struct Slot {
+        bool inTables;
+        typename std::list<Entry>::iterator at;
+    };
+
+    size_t cap;
+    uint64_t threshold;
+    mutable std::mutex m;
+    std::list<Entry> probation, tableList;  // most recently used first
+    std::unordered_map<std::string, Slot> index;
+    size_t tables = 0, bytes = 0;
+    uint64_t hits = 0, misses = 0, builds = 0, evictions = 0;
+
+    // The rest run with m held
+
+    typename std::unordered_map<std::string, Slot>::iterator admit(const std::string& key) {
+        if (probation.size() >= cap) {
+            index.erase(probation.back().key);
+            probation.pop_back();
+        }
+        probation.emplace_front();
+        probation.front().key = key;
+        return index.emplace(key, Slot{ false, probation.begin() }).first;
+    }
+
+    void promote(typename std::unordered_map<std::string, Slot>::iterator it) {
+        if (tableList.size() >= cap) {
+            Entry& old = tableList.back();
+            if (old.table) {
+                tables--;
+                bytes -= old.table->bytes();
+            }
+            index.erase(old.key);
+            tableList.pop_back();
+            evictions++;
+        }
+        tableList.splice(tableList.begin(), probation, it->second.at);
+        it->second.inTables = true;
+    }
+
+    void drop(const std::string& key) {
+        auto it = index.find(key);
+        if (it == index.end() || !it->second.inTables || it->second.at->table) return;
+        tableList.erase(it->second.at);
+        index.erase(it);
+    }
+};
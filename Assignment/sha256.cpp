@@ -0,0 +1,291 @@
+#include "sha256.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA_X86 1
+#endif
+
+using namespace std;
+using namespace NTL;
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+// Portable kernel, 16-word rolling message schedule
+static void compressPortable(uint32_t state[8], const unsigned char* p, size_t blocks) {
+    for (; blocks > 0; blocks--, p += 64) {
+        uint32_t w[16];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            if (i >= 16) {
+                uint32_t x = w[(i + 1) & 15], y = w[(i + 14) & 15];
+                uint32_t s0 = rotr(x, 7) ^ rotr(x, 18) ^ (x >> 3);
+                uint32_t s1 = rotr(y, 17) ^ rotr(y, 19) ^ (y >> 10);
+                w[i & 15] += s0 + w[(i + 9) & 15] + s1;
+            }
+            uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i & 15];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+#ifdef SHA_X86
+// SHA-NI kernel: the state lives as (A,B,E,F) / (C,D,G,H) halves, each sha256rnds2 does two rounds,
+// and message group i+4 is derived from groups i..i+3 right after group i is consumed
+__attribute__((target("sha,sse4.1,ssse3")))
+static void compressSHANI(uint32_t state[8], const unsigned char* p, size_t blocks) {
+    const __m128i BSWAP = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1);   // CDAB
+    __m128i s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B);    // EFGH
+    __m128i s0 = _mm_alignr_epi8(tmp, s1, 8);                                             // ABEF
+    s1 = _mm_blend_epi16(s1, tmp, 0xF0);                                                  // CDGH
+
+    for (; blocks > 0; blocks--, p += 64) {
+        __m128i abef = s0, cdgh = s1;
+        __m128i m[4];
+        for (int i = 0; i < 4; i++) m[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16 * i)), BSWAP);
+        for (int i = 0; i < 16; i++) {
+            __m128i msg = _mm_add_epi32(m[i & 3], _mm_loadu_si128((const __m128i*)&K[4 * i]));
+            s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+            s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(msg, 0x0E));
+            if (i < 12) {
+                __m128i t = _mm_add_epi32(_mm_sha256msg1_epu32(m[i & 3], m[(i + 1) & 3]),
+                                          _mm_alignr_epi8(m[(i + 3) & 3], m[(i + 2) & 3], 4));
+                m[i & 3] = _mm_sha256msg2_epu32(t, m[(i + 3) & 3]);
+            }
+        }
+        s0 = _mm_add_epi32(s0, abef);
+        s1 = _mm_add_epi32(s1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(s0, 0x1B);                                                    // FEBA
+    s1 = _mm_shuffle_epi32(s1, 0xB1);                                                     // DCHG
+    _mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(tmp, s1, 0xF0));                // DCBA
+    _mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(s1, tmp, 8));                   // HGFE
+}
+
+static bool cpuHasSHA() {
+    unsigned a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d)) return false;
+    bool sse41 = c & bit_SSE4_1, ssse3 = c & bit_SSSE3;
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return false;
+    return sse41 && ssse3 && (b & bit_SHA);
+}
+#endif
+
+static bool hardwareSHA() {
+#ifdef SHA_X86
+    static const bool has = cpuHasSHA();
+    return has;
+#else
+    return false;
+#endif
+}
+
+Sha256::Sha256(bool allowHardware) {
+#ifdef SHA_X86
+    if (allowHardware && hardwareSHA()) {
+        compress = compressSHANI;
+        name = "sha-ni";
+        reset();
+        return;
+    }
+#endif
+    (void)allowHardware;
+    compress = compressPortable;
+    name = "portable";
+    reset();
+}
+
+const char* Sha256::kernelName() {
+    return hardwareSHA() ? "sha-ni" : "portable";
+}
+
+void Sha256::reset() {
+    memcpy(h, H0, sizeof(h));
+    bufLen = 0;
+    total = 0;
+}
+
+void Sha256::update(const void* data, size_t n) {
+    const unsigned char* p = (const unsigned char*)data;
+    total += n;
+    if (bufLen > 0) {
+        size_t take = min(n, 64 - bufLen);
+        memcpy(buf + bufLen, p, take);
+        bufLen += take;
+        p += take;
+        n -= take;
+        if (bufLen < 64) return;
+        compress(h, buf, 1);
+        bufLen = 0;
+    }
+    if (n >= 64) {
+        compress(h, p, n / 64);
+        p += n & ~size_t(63);
+        n &= 63;
+    }
+    memcpy(buf, p, n);
+    bufLen = n;
+}
+
+void Sha256::final(unsigned char out[DIGEST_BYTES]) {
+    uint64_t bits = total * 8;
+    buf[bufLen++] = 0x80;
+    if (bufLen > 56) {
+        memset(buf + bufLen, 0, 64 - bufLen);
+        compress(h, buf, 1);
+        bufLen = 0;
+    }
+    memset(buf + bufLen, 0, 56 - bufLen);
+    for (int i = 0; i < 8; i++) buf[56 + i] = (unsigned char)(bits >> (56 - 8 * i));
+    compress(h, buf, 1);
+    for (int i = 0; i < 8; i++) {
+        out[4 * i] = (unsigned char)(h[i] >> 24);
+        out[4 * i + 1] = (unsigned char)(h[i] >> 16);
+        out[4 * i + 2] = (unsigned char)(h[i] >> 8);
+        out[4 * i + 3] = (unsigned char)h[i];
+    }
+    reset();
+}
+
+
+MessageSource MessageSource::file(int fd) {
+    MessageSource m;
+    m.fd = fd;
+    return m;
+}
+
+MessageSource MessageSource::buffer(const void* data, size_t n) {
+    MessageSource m;
+    m.parts.push_back({ (const unsigned char*)data, n });
+    return m;
+}
+
+MessageSource MessageSource::chunks(const ByteChunk* c, size_t n) {
+    MessageSource m;
+    m.parts.assign(c, c + n);
+    return m;
+}
+
+long long MessageSource::size() const {
+    if (fd < 0) {
+        long long n = 0;
+        for (const ByteChunk& c : parts) n += c.size;
+        return n;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return -1;
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (pos < 0) return -1;
+    return st.st_size > pos ? st.st_size - pos : 0;
+}
+
+// mmap window for regular files: large enough that remapping is free, small enough to bound RSS
+static const size_t MAP_WINDOW = size_t(16) << 20;
+static const size_t READ_CHUNK = size_t(256) << 10;
+
+static void hashRead(int fd, Sha256& h) {
+    vector<unsigned char> buf(READ_CHUNK);
+    for (;;) {
+        ssize_t got = read(fd, buf.data(), buf.size());
+        if (got == 0) return;
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error(string("MessageSource: read failed: ") + strerror(errno));
+        }
+        h.update(buf.data(), got);
+    }
+}
+
+// false if the file can't be mapped (the caller falls back to read); nothing has been hashed then
+static bool hashMapped(int fd, Sha256& h) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (pos < 0) return false;
+    off_t end = st.st_size;
+    off_t page = sysconf(_SC_PAGESIZE);
+    bool first = true;
+    while (pos < end) {
+        off_t base = pos - pos % page;
+        size_t len = (size_t)min<off_t>(end - base, MAP_WINDOW);
+        void* map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, base);
+        if (map == MAP_FAILED) {
+            if (first) return false;
+            throw runtime_error(string("MessageSource: mmap failed: ") + strerror(errno));
+        }
+        first = false;
+        madvise(map, len, MADV_SEQUENTIAL);
+        h.update((const unsigned char*)map + (pos - base), len - (pos - base));
+        munmap(map, len);
+        pos = base + len;
+    }
+    lseek(fd, end, SEEK_SET);
+    return true;
+}
+
+void MessageSource::hash(Sha256& h) const {
+    if (fd < 0) {
+        for (const ByteChunk& c : parts) h.update(c.data, c.size);
+        return;
+    }
+    if (!hashMapped(fd, h)) hashRead(fd, h);
+}
+
+
+ZZ digestToScalar(const unsigned char digest[Sha256::DIGEST_BYTES], const ZZ& n) {
+    unsigned char le[Sha256::DIGEST_BYTES];
+    for (size_t i = 0; i < Sha256::DIGEST_BYTES; i++) le[i] = digest[Sha256::DIGEST_BYTES - 1 - i];
+    ZZ e = ZZFromBytes(le, Sha256::DIGEST_BYTES);
+    long excess = 8 * (long)Sha256::DIGEST_BYTES - NumBits(n);
+    if (excess > 0) e >>= excess;
+    return e;
+}
+
+ZZ hashToScalar(const MessageSource& msg, const ZZ& n) {
+    Sha256 h;
+    msg.hash(h);
+    unsigned char d[Sha256::DIGEST_BYTES];
+    h.final(d);
+    return digestToScalar(d, n);
+}
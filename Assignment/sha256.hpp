@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <NTL/ZZ.h>
+
+// Incremental SHA-256 (FIPS 180-4). Whole blocks go straight from the caller's buffer to the
+// compression kernel, picked once at runtime: SHA-NI when the CPU has it, portable C++ otherwise.
+class Sha256 {
+public:
+    static const size_t DIGEST_BYTES = 32;
+
+    explicit Sha256(bool allowHardware = true);
+
+    void update(const void* data, size_t n);
+    // Writes the digest and resets for the next message
+    void final(unsigned char out[DIGEST_BYTES]);
+    void reset();
+
+    const char* kernel() const { return name; }
+    static const char* kernelName();                // "sha-ni" or "portable"
+
+private:
+    typedef void (*Compress)(uint32_t state[8], const unsigned char* blocks, size_t n);
+
+    Compress compress;
+    const char* name;
+    uint32_t h[8];
+    unsigned char buf[64];
+    size_t bufLen;
+    uint64_t total;
+};
+
+
+// One buffer of a chunked message
+struct ByteChunk {
+    const unsigned char* data;
+    size_t size;
+};
+
+// A message for the streaming sign/verify calls. A file descriptor is hashed from its current offset
+// to the end: regular files through read-only mmap windows (so resident memory stays at one window),
+// pipes and sockets through read(); the offset is left at the end. Chunks are hashed back to back and
+// must stay alive while the source is in use.
+class MessageSource {
+public:
+    static MessageSource file(int fd);
+    static MessageSource buffer(const void* data, size_t n);
+    static MessageSource chunks(const ByteChunk* c, size_t n);
+
+    // Bytes left to hash, -1 when unknown (pipes, sockets)
+    long long size() const;
+    // Feeds the whole message to h; throws runtime_error on I/O errors
+    void hash(Sha256& h) const;
+
+private:
+    int fd = -1;
+    std::vector<ByteChunk> parts;
+};
+
+
+// Leftmost min(256, NumBits(n)) bits of a digest as an integer (the ECDSA bits2int rule)
+NTL::ZZ digestToScalar(const unsigned char digest[Sha256::DIGEST_BYTES], const NTL::ZZ& n);
+// SHA-256 of the message through digestToScalar
+NTL::ZZ hashToScalar(const MessageSource& msg, const NTL::ZZ& n);
@@ -0,0 +1,102 @@
+#include "simdxor.hpp"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define XOR_X86 1
+#endif
+
+// Portable kernel, 8 bytes at a time
+static void xorScalar(unsigned char* out, const unsigned char* a, const unsigned char* b, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        x ^= y;
+        memcpy(out + i, &x, 8);
+    }
+    for (; i < n; i++) out[i] = a[i] ^ b[i];
+}
+
+#ifdef XOR_X86
+__attribute__((target("sse2")))
+static void xorSSE2(unsigned char* out, const unsigned char* a, const unsigned char* b, size_t n) {
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m128i x0 = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i x1 = _mm_loadu_si128((const __m128i*)(a + i + 16));
+        __m128i x2 = _mm_loadu_si128((const __m128i*)(a + i + 32));
+        __m128i x3 = _mm_loadu_si128((const __m128i*)(a + i + 48));
+        x0 = _mm_xor_si128(x0, _mm_loadu_si128((const __m128i*)(b + i)));
+        x1 = _mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)(b + i + 16)));
+        x2 = _mm_xor_si128(x2, _mm_loadu_si128((const __m128i*)(b + i + 32)));
+        x3 = _mm_xor_si128(x3, _mm_loadu_si128((const __m128i*)(b + i + 48)));
+        _mm_storeu_si128((__m128i*)(out + i), x0);
+        _mm_storeu_si128((__m128i*)(out + i + 16), x1);
+        _mm_storeu_si128((__m128i*)(out + i + 32), x2);
+        _mm_storeu_si128((__m128i*)(out + i + 48), x3);
+    }
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        x = _mm_xor_si128(x, _mm_loadu_si128((const __m128i*)(b + i)));
+        _mm_storeu_si128((__m128i*)(out + i), x);
+    }
+    xorScalar(out + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void xorAVX2(unsigned char* out, const unsigned char* a, const unsigned char* b, size_t n) {
+    size_t i = 0;
+    for (; i + 128 <= n; i += 128) {
+        __m256i x0 = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i x1 = _mm256_loadu_si256((const __m256i*)(a + i + 32));
+        __m256i x2 = _mm256_loadu_si256((const __m256i*)(a + i + 64));
+        __m256i x3 = _mm256_loadu_si256((const __m256i*)(a + i + 96));
+        x0 = _mm256_xor_si256(x0, _mm256_loadu_si256((const __m256i*)(b + i)));
+        x1 = _mm256_xor_si256(x1, _mm256_loadu_si256((const __m256i*)(b + i + 32)));
+        x2 = _mm256_xor_si256(x2, _mm256_loadu_si256((const __m256i*)(b + i + 64)));
+        x3 = _mm256_xor_si256(x3, _mm256_loadu_si256((const __m256i*)(b + i + 96)));
+        _mm256_storeu_si256((__m256i*)(out + i), x0);
+        _mm256_storeu_si256((__m256i*)(out + i + 32), x1);
+        _mm256_storeu_si256((__m256i*)(out + i + 64), x2);
+        _mm256_storeu_si256((__m256i*)(out + i + 96), x3);
+    }
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        x = _mm256_xor_si256(x, _mm256_loadu_si256((const __m256i*)(b + i)));
+        _mm256_storeu_si256((__m256i*)(out + i), x);
+    }
+    xorSSE2(out + i, a + i, b + i, n - i);
+}
+#endif
+
+typedef void (*XorKernel)(unsigned char*, const unsigned char*, const unsigned char*, size_t);
+
+struct XorDispatch {
+    XorKernel fn;
+    const char* name;
+};
+
+static XorDispatch pickXorKernel() {
+#ifdef XOR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return { xorAVX2, "avx2" };
+    if (__builtin_cpu_supports("sse2")) return { xorSSE2, "sse2" };
+#endif
+    return { xorScalar, "scalar" };
+}
+
+static const XorDispatch& xorDispatch() {
+    static const XorDispatch d = pickXorKernel();
+    return d;
+}
+
+void xorBytes(unsigned char* out, const unsigned char* a, const unsigned char* b, size_t n) {
+    xorDispatch().fn(out, a, b, n);
+}
+
+const char* xorKernelName() {
+    return xorDispatch().name;
+}
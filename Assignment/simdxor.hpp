@@ -0,0 +1,9 @@
+#pragma once
+#include <cstddef>
+
+// out[i] = a[i] ^ b[i] for i < n. out may alias a or b (in-place); other overlaps are not allowed.
+// Dispatches once at runtime to an AVX2, SSE2 or portable kernel.
+void xorBytes(unsigned char* out, const unsigned char* a, const unsigned char* b, size_t n);
+
+// Name of the kernel xorBytes dispatches to ("avx2", "sse2" or "scalar")
+const char* xorKernelName();
@@ -0,0 +1,111 @@
+#include "wire.hpp"
+#include "instrument.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace NTL;
+
+void encodeScalar(const ZZ& k, unsigned char* out, long len) {
+    if (k < 0 || NumBytes(k) > len) throw runtime_error("encodeScalar: value does not fit the field width");
+    BytesFromZZ(out, k, len);               // little-endian, zero padded
+    reverse(out, out + len);
+}
+
+ZZ decodeScalar(const unsigned char* in, long len) {
+    thread_local vector<unsigned char> le;
+    le.assign(in, in + len);
+    reverse(le.begin(), le.end());
+    return ZZFromBytes(le.data(), len);
+}
+
+
+void encodeSignature(const pair<ZZ, ZZ>& sig, long len, unsigned char* out) {
+    encodeScalar(sig.first, out, len);
+    encodeScalar(sig.second, out + len, len);
+}
+
+pair<ZZ, ZZ> decodeSignature(const unsigned char* in, long len) {
+    return make_pair(decodeScalar(in, len), decodeScalar(in + len, len));
+}
+
+void encodeSignatures(const pair<ZZ, ZZ>* sigs, size_t n, long len, unsigned char* out) {
+    for (size_t i = 0; i < n; i++) encodeSignature(sigs[i], len, out + i * 2 * len);
+}
+
+void decodeSignatures(const unsigned char* in, size_t n, long len, pair<ZZ, ZZ>* out) {
+    for (size_t i = 0; i < n; i++) out[i] = decodeSignature(in + i * 2 * len, len);
+}
+
+
+// Recoding of e >= 0; the empty schedule stands for e = 0
+static ExpRecoding recodeExponent(const ZZ& e) {
+    if (IsZero(e)) {
+        ExpRecoding r;
+        r.w = 1;
+        return r;
+    }
+    return slidingWindowRecode(e, slidingWindowWidth(NumBits(e)));
+}
+
+ModSqrt::ModSqrt(const ZZ& p) {
+    if (p < 3 || !bit(p, 0)) return;        // left unusable, operator() throws
+    ZZ_pPush push(p);
+    if (bit(p, 1)) {
+        s = 1;
+        exp = recodeExponent((p + 1) / 4);
+        return;
+    }
+    ZZ q = p - 1;
+    s = 0;
+    while (!bit(q, 0)) {
+        q >>= 1;
+        s++;
+    }
+    ZZ n(2);
+    while (n < p && Jacobi(n, p) != -1) n += 1;
+    if (n >= p) {
+        s = 0;
+        return;
+    }
+    CRYPTO_COUNT(CTR_MODEXP);
+    z = rep(power(conv<ZZ_p>(n), q));
+    exp = recodeExponent(q / 2);
+}
+
+bool ModSqrt::operator()(ZZ_p& r, const ZZ_p& a) const {
+    if (s == 0) throw runtime_error("ModSqrt: modulus is not an odd prime");
+    if (IsZero(a)) {
+        clear(r);
+        return true;
+    }
+    if (s == 1) {
+        r = slidingWindowPower(a, exp);
+        return sqr(r) == a;
+    }
+
+    // Tonelli-Shanks with t = a^((q-1)/2): r = a t, b = a t^2 = a^q
+    ZZ_p t = slidingWindowPower(a, exp);
+    ZZ_p x = a * t;
+    ZZ_p b = x * t;
+    ZZ_p c = conv<ZZ_p>(z);
+    long m = s;
+    while (!IsOne(b)) {
+        // least i with b^(2^i) = 1
+        long i = 0;
+        ZZ_p b2 = b;
+        while (!IsOne(b2)) {
+            sqr(b2, b2);
+            if (++i == m) return false;     // a is a non-residue
+        }
+        ZZ_p d = c;
+        for (long k = 0; k < m - i - 1; k++) sqr(d, d);
+        mul(x, x, d);
+        sqr(c, d);
+        mul(b, b, c);
+        m = i;
+    }
+    r = x;
+    return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <NTL/ZZ.h>
+#include <NTL/ZZ_p.h>
+#include "modexp.hpp"
+
+// Fixed-width big-endian integers for the binary wire format
+
+// k as exactly len bytes, most significant first; throws runtime_error if k < 0 or k >= 256^len
+void encodeScalar(const NTL::ZZ& k, unsigned char* out, long len);
+NTL::ZZ decodeScalar(const unsigned char* in, long len);
+
+// ECDSA (r, s) as r || s, len bytes each (NumBytes(q) for a group of order q); decoding does not
+// range-check, verification does
+void encodeSignature(const std::pair<NTL::ZZ, NTL::ZZ>& sig, long len, unsigned char* out);
+std::pair<NTL::ZZ, NTL::ZZ> decodeSignature(const unsigned char* in, long len);
+void encodeSignatures(const std::pair<NTL::ZZ, NTL::ZZ>* sigs, size_t n, long len, unsigned char* out);
+void decodeSignatures(const unsigned char* in, size_t n, long len, std::pair<NTL::ZZ, NTL::ZZ>* out);
+
+
+// Square roots modulo an odd prime p, set up once per modulus: one exponentiation by (p+1)/4 when
+// p = 3 mod 4, Tonelli-Shanks otherwise (p - 1 = q * 2^s, at most s^2 / 2 extra squarings)
+class ModSqrt {
+public:
+    ModSqrt() {}
+    explicit ModSqrt(const NTL::ZZ& p);
+
+    // r^2 = a in the current modulus (which must be p); false when a is a non-residue
+    bool operator()(NTL::ZZ_p& r, const NTL::ZZ_p& a) const;
+    // (p+1)/4 when p = 3 mod 4, so a fixed-width field can take the root itself; null otherwise
+    const ExpRecoding* threeModFourExponent() const { return s == 1 ? &exp : nullptr; }
+
+private:
+    long s = 0;              // 2-adic valuation of p - 1 (1 selects the (p+1)/4 path, 0 unusable)
+    NTL::ZZ z;               // non-residue raised to q, the 2^s-th root of unity generator
+    ExpRecoding exp;         // (p+1)/4, or (q-1)/2 for Tonelli-Shanks
+};